@@ -0,0 +1,74 @@
+#ifndef HBONSAI_ALLOC_STATS_H
+#define HBONSAI_ALLOC_STATS_H
+
+#include <array>
+#include <cstddef>
+#include <ostream>
+
+namespace hbonsai {
+
+// --alloc-stats: the hbonsai executable replaces the global operator new and
+// delete to count allocations by phase of the run. Counting is on from the
+// start of the process, so that parsing the command line is measured too,
+// and main() stops it for good unless the option was given; from then on an
+// allocation costs one relaxed atomic load more than it would otherwise.
+//
+// The phase API lives in src/alloc/AllocPhase.cpp and the counters and the
+// operator new replacement in src/alloc/AllocStats.cpp, so that a program may
+// mark phases without taking over operator new: only the hbonsai executable
+// links AllocStats.cpp, and libhbonsai links neither.
+
+enum class AllocPhase {
+    Startup,    // static initialisation, before main()
+    Config,     // parsing the command line
+    FirstFrame, // terminal setup up to the first frame, less generation
+    Generation, // Bonsai::generate() and, in --survey and --find-seed, the whole run
+    Frames,     // every later frame
+    Exit,       // terminal teardown
+};
+
+inline constexpr std::size_t kAllocPhaseCount = 6;
+
+struct AllocCounts {
+    long long allocations = 0;
+    long long frees = 0;
+    long long bytes = 0;     // allocated, as the allocator rounds the requests
+    long long peakBytes = 0; // most bytes live at an allocation or free in the phase
+};
+
+struct AllocReport {
+    std::array<AllocCounts, kAllocPhaseCount> phases;
+    AllocCounts total;
+    long long liveBytes = 0; // still allocated when the report was taken
+};
+
+// Phase that allocations and frees are charged to from now on, on every thread.
+void set_alloc_phase(AllocPhase phase);
+AllocPhase alloc_phase();
+// "startup", "config", "first-frame", "generation", "frames" or "exit".
+const char* alloc_phase_name(AllocPhase phase);
+
+// Charges allocations to a phase for the lifetime of the scope, then goes
+// back to the phase before it.
+class AllocPhaseScope {
+public:
+    explicit AllocPhaseScope(AllocPhase phase) : previous_(alloc_phase()) { set_alloc_phase(phase); }
+    ~AllocPhaseScope() { set_alloc_phase(previous_); }
+    AllocPhaseScope(const AllocPhaseScope&) = delete;
+    AllocPhaseScope& operator=(const AllocPhaseScope&) = delete;
+
+private:
+    AllocPhase previous_;
+};
+
+// The rest needs AllocStats.cpp. Stops counting; it cannot be restarted.
+void stop_alloc_stats();
+bool alloc_stats_enabled();
+
+AllocReport alloc_stats_report();
+// A table, or one JSON object with json.
+void print_alloc_stats(std::ostream& os, const AllocReport& report, bool json);
+
+} // namespace hbonsai
+
+#endif // HBONSAI_ALLOC_STATS_H
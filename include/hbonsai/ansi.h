@@ -0,0 +1,75 @@
+#ifndef HBONSAI_ANSI_H
+#define HBONSAI_ANSI_H
+
+#include "bonsai.h"
+#include "config.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hbonsai {
+
+// A plain grid of coloured cells that can be encoded as ANSI escape sequences
+// without a terminal library. Used wherever a tree must be produced as text.
+class AnsiCanvas {
+public:
+    struct Cell {
+        wchar_t ch = L' ';
+        const char* egc = nullptr; // full grapheme cluster, when ch alone is not enough
+        int colorIndex = -1; // -1 is the terminal default
+        bool bold = false;
+        bool continuation = false; // right half of a wide character
+    };
+
+    AnsiCanvas(int rows, int cols);
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    const Cell& at(int y, int x) const { return cells_[static_cast<size_t>(y) * cols_ + x]; }
+
+    void clear();
+    // Places one character and returns the number of columns it occupies.
+    int put(int y, int x, wchar_t ch, int colorIndex, bool bold);
+    // Places a tree part using its cached width and grapheme cluster.
+    void put(const TreePart& part);
+    void putText(int y, int x, const std::wstring& text, int colorIndex, bool bold);
+
+    // Appends the whole canvas, row by row, the way cbonsai's --print does.
+    void encode(std::string& out) const;
+    // Appends the cursor moves and cells that turn `previous`, a canvas of the
+    // same size already on screen, into this one. Unchanged cells cost nothing.
+    void encodeDiff(const AnsiCanvas& previous, std::string& out) const;
+
+private:
+    void place(int y, int x, int width, const Cell& cell);
+
+    int rows_;
+    int cols_;
+    std::vector<Cell> cells_;
+};
+
+// Appends an SGR sequence selecting the given palette index and weight.
+void append_sgr(std::string& out, int colorIndex, bool bold);
+
+// Appends an OSC 4 sequence redefining palette slot `index` as 0xRRGGBB.
+void append_palette(std::string& out, int index, std::uint32_t rgb);
+
+// Draws pot, tree and message onto the canvas exactly as Renderer::drawStatic does.
+void compose_tree(AnsiCanvas& canvas, const std::vector<TreePart>& parts, const BonsaiConfig& config);
+// Draws parts[i] for every i in indices that falls in the tree area, then the
+// message, as Renderer::drawLive does. Does nothing for no indices.
+void compose_parts(AnsiCanvas& canvas, const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                   const BonsaiConfig& config);
+// Same for standalone effect cells, as Renderer::drawCells does.
+void compose_cells(AnsiCanvas& canvas, const std::vector<TreePart>& cells, const BonsaiConfig& config);
+// Draws the title text, as Renderer::renderTitle does.
+void compose_title(AnsiCanvas& canvas, const TitleConfig& config);
+
+// Convenience wrapper: composes a rows x cols canvas and returns its encoding.
+std::string render_ansi(const std::vector<TreePart>& parts, const BonsaiConfig& config, int rows, int cols);
+
+} // namespace hbonsai
+
+#endif // HBONSAI_ANSI_H
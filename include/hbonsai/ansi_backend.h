@@ -0,0 +1,67 @@
+#ifndef HBONSAI_ANSI_BACKEND_H
+#define HBONSAI_ANSI_BACKEND_H
+
+#include "ansi.h"
+#include "render_backend.h"
+
+#include <chrono>
+#include <string>
+#include <termios.h>
+
+namespace hbonsai {
+
+// Writes straight to the controlling terminal without a terminal library.
+// Drawing goes to a back buffer; render() sends only the cells that differ
+// from the front buffer, which mirrors what is on screen.
+class AnsiBackend : public RenderBackend {
+public:
+    AnsiBackend();
+    // Drives the terminal on fd instead of /dev/tty, e.g. a pty in a
+    // benchmark. Takes ownership of fd.
+    explicit AnsiBackend(int fd);
+    ~AnsiBackend() override;
+
+    AnsiBackend(const AnsiBackend&) = delete;
+    AnsiBackend& operator=(const AnsiBackend&) = delete;
+
+    bool isInitialized() const override;
+    std::pair<int, int> dimensions() const override;
+    void prepareFrame(const BonsaiConfig& config) override;
+    void drawStatic(const std::vector<TreePart>& parts, const BonsaiConfig& config) override;
+    void drawLive(const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                  const BonsaiConfig& config) override;
+    void drawCells(const std::vector<TreePart>& cells, const BonsaiConfig& config) override;
+    void renderTitle(const TitleConfig& config) override;
+    bool setPalette(const std::vector<PaletteEntry>& entries) override;
+    bool canSetPalette() const override;
+    void render() override;
+    void wait() override;
+    bool pollInput(InputEvent& event) override;
+    int inputFd() const override;
+    BackendStats stats() const override;
+
+private:
+    void attach(int fd, std::chrono::steady_clock::time_point start);
+    bool readInput(int timeoutMs);
+    // Waits up to timeoutMs (-1 for ever) for a key. An incomplete escape
+    // sequence gets a short grace period to finish.
+    bool readKey(InputEvent& event, int timeoutMs);
+    void writeAll(const std::string& data);
+
+    int fd_ = -1;
+    bool initialized_ = false;
+    struct termios savedTermios_{};
+    AnsiCanvas front_;
+    AnsiCanvas back_;
+    std::string out_;
+    std::string palette_; // OSC 4 sequences waiting for the next render()
+    bool paletteChanged_ = false;
+    std::string input_;
+    double startupMs_ = 0.0;
+    long long frames_ = 0;
+    long long bytes_ = 0;
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_ANSI_BACKEND_H
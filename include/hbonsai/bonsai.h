@@ -2,11 +2,16 @@
 #define HBONSAI_BONSAI_H
 
 #include "config.h"
+#include "part_index.h"
+#include "utf8.h"
 #include <vector>
 #include <string>
 #include <utility>
+#include <atomic>
 #include <cstdint>
 #include <cwchar>
+#include <memory>
+#include <limits>
 #include <random>
 
 namespace hbonsai {
@@ -15,44 +20,127 @@ namespace hbonsai {
 struct TreePart {
     int x = 0;
     int y = 0;
-    wchar_t ch = L' ';
+    wchar_t ch = L' ';      // leading code point of the glyph
     int colorIndex = 0;
     bool bold = false;
+    bool leaf = false;      // drawn from the leaf list rather than a wood glyph
+    std::uint8_t width = 1; // terminal columns, measured once when the leaf is loaded
+    // Growth step that emitted the part: every glyph of one step of one branch
+    // shares it, and steps count up from 0 in drawing order. Sits in what was
+    // padding, so TreePart stays 32 bytes.
+    std::uint32_t step = 0;
+    // Full grapheme cluster for leaf glyphs (e.g. emoji with ZWJ or variation
+    // selectors); nullptr for single-code-point wood glyphs. Points into the
+    // Bonsai that generated the part and is valid for that object's lifetime.
+    const char* egc = nullptr;
 };
 
-class Bonsai {
-public:
-    explicit Bonsai(const BonsaiConfig& config);
+enum class BranchType { Trunk, ShootLeft, ShootRight, Dying, Dead };
 
-    std::vector<TreePart> generate(int height, int width);
+// A leaf string, pre-split into grapheme clusters with cached widths.
+using Leaf = std::vector<Grapheme>;
 
-private:
-    const BonsaiConfig& config_;
+class WorkStealingPool;
 
-    enum class BranchType { Trunk, ShootLeft, ShootRight, Dying, Dead };
+// Which of BonsaiConfig's generation budgets cut a tree short.
+enum class Truncation {
+    None,
+    Parts,
+    Branches,
+    Memory,
+    Time,
+};
 
+// "parts", "branches", "memory", "time" or "none".
+const char* truncation_name(Truncation reason);
+
+class Bonsai {
+public:
     struct Counters {
         int branches = 0;
         int shoots = 0;
         int shootCounter = 0;
+        long long steps = 0; // iterations of the growth loop
     };
 
-    std::vector<std::wstring> leaves_;
+    // What survey() measures about one tree.
+    struct Summary {
+        long long parts = 0;  // as many as generate() would return
+        long long leaves = 0; // of which leaf glyphs
+        Counters counters;
+        // Cells the tree covers, wide leaves included. Empty when minX > maxX.
+        int minX = std::numeric_limits<int>::max();
+        int maxX = std::numeric_limits<int>::min();
+        int minY = std::numeric_limits<int>::max();
+        int maxY = std::numeric_limits<int>::min();
+        // Cells on the tree area's left, right or top edge, where growth that
+        // runs into the border piles up.
+        long long edge = 0;
+        bool abandoned = false; // stopped by SurveyLimits; the counts are partial
+        // Budget that cut the tree short, as it would generate(). The time
+        // budget does not apply to surveys.
+        Truncation truncation = Truncation::None;
+    };
+
+    // Bounds past which survey() gives up on a tree. Every count only grows
+    // as a tree grows, so the tree is abandoned as soon as one is exceeded.
+    struct SurveyLimits {
+        long long parts = std::numeric_limits<long long>::max();
+        long long leaves = std::numeric_limits<long long>::max();
+        long long edge = std::numeric_limits<long long>::max();
+        int branches = std::numeric_limits<int>::max();
+        int shoots = std::numeric_limits<int>::max();
+        int height = std::numeric_limits<int>::max();
+        int width = std::numeric_limits<int>::max();
+        // The tree is also abandoned once *cutoff drops below ordinal, so a
+        // search can call off trees it no longer needs.
+        const std::atomic<long long>* cutoff = nullptr;
+        long long ordinal = 0;
+    };
+
+    explicit Bonsai(const BonsaiConfig& config);
+    ~Bonsai();
+
+    // Grows the next tree. Stops early, with a partial but complete-looking
+    // tree, if it runs into one of the config's budgets: every open branch
+    // finishes its current growth step, so the tree may end up to a step per
+    // open branch past a parts or branch budget.
+    std::vector<TreePart> generate(int height, int width);
+
+    // Grows the first tree generate() would give for `seed`, with the serial
+    // engine, but only counts it: no parts are stored. Leaves this object's
+    // own random state alone, so one Bonsai can survey many seeds, and is safe
+    // to call from several threads at once.
+    Summary survey(unsigned int seed, int height, int width) const;
+    Summary survey(unsigned int seed, int height, int width, const SurveyLimits& limits) const;
+
+    // Counters of the most recent generate() call.
+    const Counters& lastCounters() const { return counters_; }
+    // Budget that cut the most recent generate() call short, if any.
+    Truncation lastTruncation() const { return truncation_; }
+    // Row index over the parts returned by the most recent generate() call.
+    const PartIndex& lastIndex() const { return index_; }
+
+private:
+    // Parallel-deterministic mode (BonsaiConfig::parallel): every sub-branch
+    // draws from its own Philox stream keyed on the seed and its branch path,
+    // large subtrees grow on a work-stealing pool, and the pieces are merged
+    // back in depth-first order. Reproducible per seed, but a different tree
+    // from the serial engine.
+    std::vector<TreePart> generateParallel();
+
+    const BonsaiConfig& config_;
+    Counters counters_;
+    Truncation truncation_ = Truncation::None;
+    PartIndex index_;
+    std::vector<Leaf> leaves_;
     int treeHeight_ = 0;
     int treeWidth_ = 0;
 
     std::mt19937 rng_;
-
-    int roll(int max);
-    std::pair<int, int> setDeltas(BranchType type, int life, int age, int multiplier);
-    std::wstring chooseString(BranchType type, int life, int dx, int dy);
-    int chooseColor(BranchType type, bool& bold);
-    void emitString(int y, int x, const std::wstring& str, int colorIndex, bool bold,
-                    std::vector<TreePart>& parts);
-
-    // Recursive branch growth translated from ref.c
-    void branch(int y, int x, int life, BranchType type, Counters& counters,
-                std::vector<TreePart>& parts);
+    std::uint64_t parallelKey_ = 0;
+    std::uint64_t parallelTrees_ = 0;
+    std::unique_ptr<WorkStealingPool> pool_;
 };
 
 } // namespace hbonsai
@@ -6,21 +6,43 @@
 
 #include "hbonsai/bonsai.h"
 #include "hbonsai/config.h"
+#include "hbonsai/pacing.h"
+#include "hbonsai/particles.h"
 #include "hbonsai/scene.h"
+#include "hbonsai/seasons.h"
+#include "hbonsai/timeline.h"
+#include "hbonsai/wind.h"
 
 namespace hbonsai {
 
+// Trees the scene has grown, for the --verbose report.
+struct GrowthStats {
+    long long trees = 0;
+    long long truncated = 0; // cut short by a generation budget
+    Truncation lastTruncation = Truncation::None;
+    std::size_t lastTruncatedParts = 0;
+};
+
 class BonsaiScene : public Scene {
 public:
-    BonsaiScene(const AppConfig& appConfig, const BonsaiConfig& bonsaiConfig, const TitleConfig& titleConfig);
+    // With --pace, the pacer's report for each finished tree is copied to
+    // paceStats if given; every tree grown is counted in growthStats if given.
+    BonsaiScene(const AppConfig& appConfig, const BonsaiConfig& bonsaiConfig, const TitleConfig& titleConfig,
+                PaceStats* paceStats = nullptr, GrowthStats* growthStats = nullptr);
 
     void onEnter(Renderer& renderer) override;
+    void onInput(const InputEvent& event) override;
     void update(double dt) override;
     void draw(Renderer& renderer) override;
     bool isFinished() const override;
 
 private:
     void resetState();
+    void releaseNext();
+    void seekTo(std::size_t target);
+    void drawEffects(Renderer& renderer);
+    void applySeason(Renderer& renderer, bool treeShown);
+    bool effectsEnabled() const;
 
     const AppConfig& appConfig_;
     const BonsaiConfig& bonsaiConfig_;
@@ -28,15 +50,27 @@ private:
     Bonsai bonsai_;
     std::vector<TreePart> parts_;
     std::vector<std::size_t> pendingParts_;
+    GrowthTimeline timeline_;
+    WindEffect wind_;
+    LeafParticles particles_;
+    SeasonCycle seasons_;
+    GrowthPacer pacer_;
+    FrameCost frameCost_; // as last reported by the renderer
+    PaceStats* paceStats_;
+    GrowthStats* growthStats_;
+    std::vector<TreePart> effectCells_;
     int treeHeight_ = 0;
     int treeWidth_ = 0;
     std::size_t nextIndex_ = 0;
     double accumulator_ = 0.0;
     bool started_ = false;
     bool finished_ = false;
+    bool paused_ = false;
+    bool dismissed_ = false; // a key was pressed while post-growth effects ran
     bool framePrepared_ = false;
     bool staticDrawn_ = false;
     double titleElapsed_ = 0.0;
+    double waitElapsed_ = 0.0;
     bool titleVisible_ = false;
 };
 
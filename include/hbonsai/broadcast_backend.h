@@ -0,0 +1,89 @@
+#ifndef HBONSAI_BROADCAST_BACKEND_H
+#define HBONSAI_BROADCAST_BACKEND_H
+
+#include "ansi.h"
+#include "render_backend.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hbonsai {
+
+// Shows one scene on several terminals at once (--broadcast). Drawing goes to
+// a single back buffer and render() encodes the diff once; every output then
+// gets the same bytes through its own non-blocking descriptor.
+//
+// An output still busy with an earlier frame does not queue the new one: it
+// is marked stale, and once it has drained it gets a keyframe (clear screen
+// plus the whole current canvas) instead. A slow or stuck terminal therefore
+// never holds up the others, and each output keeps at most one frame in
+// memory.
+class BroadcastBackend : public RenderBackend {
+public:
+    // Opens every path for writing. The canvas is the smallest of the
+    // outputs' sizes.
+    explicit BroadcastBackend(const std::vector<std::string>& paths);
+    // Takes ownership of already open descriptors, e.g. ptys in a benchmark.
+    explicit BroadcastBackend(const std::vector<int>& fds);
+    ~BroadcastBackend() override;
+
+    BroadcastBackend(const BroadcastBackend&) = delete;
+    BroadcastBackend& operator=(const BroadcastBackend&) = delete;
+
+    bool isInitialized() const override;
+    std::pair<int, int> dimensions() const override;
+    void prepareFrame(const BonsaiConfig& config) override;
+    void drawStatic(const std::vector<TreePart>& parts, const BonsaiConfig& config) override;
+    void drawLive(const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                  const BonsaiConfig& config) override;
+    void drawCells(const std::vector<TreePart>& cells, const BonsaiConfig& config) override;
+    void renderTitle(const TitleConfig& config) override;
+    bool setPalette(const std::vector<PaletteEntry>& entries) override;
+    bool canSetPalette() const override;
+    void render() override;
+    // No output has a keyboard: flushes every output, then sleeps until a
+    // signal ends the process.
+    void wait() override;
+    bool pollInput(InputEvent& event) override;
+    int inputFd() const override;
+    BackendStats stats() const override;
+
+private:
+    using Frame = std::shared_ptr<const std::string>;
+
+    struct Output {
+        int fd = -1;
+        Frame pending; // frame being written; nullptr when caught up
+        std::size_t offset = 0;
+        bool stale = false; // missed a frame, needs a keyframe next
+        long long bytes = 0;
+        long long skipped = 0;
+        long long keyframes = 0;
+    };
+
+    void attach(const std::vector<int>& fds);
+    const Frame& keyframe();
+    // Queues the whole current canvas for an output that missed frames.
+    void sendKeyframe(Output& out);
+    // Writes as much of out.pending as the descriptor takes without blocking.
+    void flush(Output& out);
+    // Waits up to timeoutMs (-1 for ever) for outputs with a pending frame to
+    // take more of it. False if none has one.
+    bool flushPending(int timeoutMs);
+
+    bool initialized_ = false;
+    std::vector<Output> outputs_;
+    AnsiCanvas front_;
+    AnsiCanvas back_;
+    Frame keyframe_; // whole front_ canvas, built at most once per frame
+    std::string palette_;           // OSC 4 sequences waiting for the next render()
+    std::vector<std::int64_t> rgb_; // current rgb per palette slot, -1 if never set
+    double startupMs_ = 0.0;
+    long long frames_ = 0;
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_BROADCAST_BACKEND_H
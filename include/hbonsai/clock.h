@@ -0,0 +1,45 @@
+#ifndef HBONSAI_CLOCK_H
+#define HBONSAI_CLOCK_H
+
+namespace hbonsai {
+
+// Time source for the frame loop. Times are seconds from an arbitrary origin.
+class Clock {
+public:
+    virtual ~Clock() = default;
+
+    virtual double now() = 0;
+    // Sleeps for up to `seconds`. If wakeFd is a valid descriptor, returns
+    // early as soon as it becomes readable.
+    virtual void sleepFor(double seconds, int wakeFd = -1) = 0;
+};
+
+// Wall-clock time; sleeping blocks the thread.
+class SteadyClock : public Clock {
+public:
+    double now() override;
+    void sleepFor(double seconds, int wakeFd = -1) override;
+};
+
+// Simulated time that only moves when slept on, so the frame loop runs as fast
+// as the CPU allows while scenes still see realistic frame deltas.
+class VirtualClock : public Clock {
+public:
+    double now() override { return now_; }
+    void sleepFor(double seconds, int wakeFd = -1) override {
+        (void)wakeFd;
+        advance(seconds);
+    }
+    void advance(double seconds) {
+        if (seconds > 0.0) {
+            now_ += seconds;
+        }
+    }
+
+private:
+    double now_ = 0.0;
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_CLOCK_H
@@ -8,13 +8,52 @@
 
 namespace hbonsai {
 
+enum class BackendKind {
+    Auto,      // ansi when the terminal's capabilities are cached, else notcurses
+    Notcurses,
+    Ansi, // raw escape sequences to /dev/tty, no terminal library
+};
+
 struct AppConfig {
     bool live = false;
+    bool wholeSteps = false; // live mode releases a whole growth step per tick, not one glyph
     bool infinite = false;
+    double waitTime = 4.0; // infinite mode: pause between trees, in seconds
     bool screensaver = false;
     bool printTree = false;
     int verbosity = 0;
+    bool allocStats = false;     // --alloc-stats: report allocations by phase at exit
+    bool allocStatsJson = false; // as JSON rather than a table
     float timeStep = 0.03f;
+    bool pace = false;        // live mode adapts frame rate and batch size to the terminal
+    double paceSeconds = 0.0; // --pace target growth time; 0 means parts x timeStep
+    // Not Auto by default: the ANSI backend does not follow terminal resizes.
+    BackendKind backend = BackendKind::Notcurses;
+    std::string termcapsFile; // capability cache used by BackendKind::Auto
+    std::vector<std::string> broadcast; // --broadcast: terminals that all show the one scene
+    int windBudget = 0; // leaves the post-growth wind may move per frame; 0 disables it
+    int fallingLeaves = 0; // capacity of the falling-leaves particle pool; 0 disables it
+    double seasonPeriod = 0.0; // seconds for one cycle of seasonal colours; 0 disables it
+    int checkpointInterval = 256;  // live-mode seek checkpoint spacing, in parts
+    int checkpointMemoryKb = 4096; // cap on checkpoint memory; the spacing doubles to fit
+
+    // hbonsaid: serve pre-rendered trees over a Unix domain socket
+    bool daemon = false;
+    bool client = false;
+    std::string socketPath;
+    int daemonWorkers = 2;
+    int daemonPoolSize = 8;
+
+    // --survey: count trees for many seeds instead of drawing one
+    long long survey = 0; // trees to survey; 0 disables it
+    int surveyRows = 24;  // terminal size the trees are grown for
+    int surveyCols = 80;
+    bool surveyCsv = false; // one row per tree instead of histograms
+
+    // --find-seed: constraints such as "width>=80%"; empty disables it
+    std::vector<std::string> findSeed;
+    int findCount = 1;               // matching seeds to stop after
+    long long findLimit = 100000000; // seeds to try at most
 };
 
 struct BonsaiConfig {
@@ -23,6 +62,14 @@ struct BonsaiConfig {
     int baseType = 1;
     int seed = 0;
     int targetBranchCount = 0;
+    bool parallel = false; // subtree-parallel deterministic generation
+    int threads = 0;       // worker threads for parallel mode; 0 = all cores
+    // Generation budgets; 0 lifts one. A tree that runs into one stops growing
+    // and is kept as it stands (Bonsai::lastTruncation()).
+    long long maxParts = 2000000;
+    int maxBranches = 0;
+    long long maxMemoryKb = 0; // storage for the tree's parts
+    double maxSeconds = 0.0;
     std::string message;
     std::vector<std::string> leaves = {"&"};
     std::array<int, 4> colors = {2, 3, 10, 11};
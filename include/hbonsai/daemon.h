@@ -0,0 +1,25 @@
+#ifndef HBONSAI_DAEMON_H
+#define HBONSAI_DAEMON_H
+
+#include <string>
+
+#include "config.h"
+
+namespace hbonsai {
+
+// Runs hbonsaid: listens on config.app.socketPath and answers each request
+// with a ready-rendered ANSI tree, keeping a pool of trees per terminal size
+// and parameter set that background threads refill. Returns the exit code.
+int run_daemon(const Config& config);
+
+// Asks hbonsaid for a tree sized to the current terminal and prints it.
+// Falls back to generating locally when no daemon answers.
+int run_client(const Config& config);
+
+// Asks the hbonsaid listening on socketPath for one rows x cols tree. Returns
+// false, with tree empty, if none answers.
+bool fetch_tree(const std::string& socketPath, const BonsaiConfig& bonsai, int rows, int cols, std::string& tree);
+
+} // namespace hbonsai
+
+#endif // HBONSAI_DAEMON_H
@@ -0,0 +1,102 @@
+/*
+ * C interface to the hbonsai tree generator (libhbonsai, target hbonsai_core).
+ *
+ * Grows trees in-process without a terminal or notcurses:
+ *
+ *     hbonsai_options options;
+ *     hbonsai_options_init(&options);
+ *     options.seed = 42;
+ *     hbonsai_generator* gen = hbonsai_create(&options);
+ *     hbonsai_generate(gen, 24, 80);
+ *     size_t length = hbonsai_render_ansi(gen, NULL, 0);
+ *     char* text = malloc(length + 1);
+ *     hbonsai_render_ansi(gen, text, length + 1);
+ *     ...
+ *     hbonsai_free(gen);
+ *
+ * A generator is not thread-safe; use one per thread.
+ */
+#ifndef HBONSAI_HBONSAI_H
+#define HBONSAI_HBONSAI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HBONSAI_API_VERSION 2
+
+/*
+ * Tree parameters, mirroring the command-line options. Always fill in with
+ * hbonsai_options_init() first: struct_size lets later versions add fields
+ * without breaking callers built against this one.
+ */
+typedef struct hbonsai_options {
+    size_t struct_size;
+    int seed;           /* -s; 0 picks a random seed */
+    int life;           /* -L, 1-200 [32] */
+    int multiplier;     /* -M, 1-20 [5] */
+    int base;           /* -b, pot style; 0 draws none [1] */
+    const char* leaves; /* -c, comma-separated UTF-8 glyphs; NULL for "&" */
+    const char* message; /* -m, drawn next to the tree; NULL for none */
+    int colors[4];      /* -k, palette indexes: dark leaves, dark wood, light leaves, light wood */
+    int parallel;       /* nonzero: --parallel engine (a different tree per seed) */
+    int threads;        /* threads for the parallel engine; 0 for all cores */
+    /* Generation budgets (version 2); 0 lifts one. See hbonsai_truncated(). */
+    long max_parts;      /* --max-parts [2000000] */
+    int max_branches;    /* --max-branches [0] */
+    long max_memory_kb;  /* --max-memory [0] */
+    double max_seconds;  /* --max-time [0] */
+} hbonsai_options;
+
+/* One cell of a generated tree, in drawing order. */
+typedef struct hbonsai_part {
+    int x;
+    int y;
+    uint32_t codepoint; /* leading code point of the glyph */
+    int color;          /* 256-colour palette index */
+    int bold;
+    int width;          /* terminal columns */
+    uint32_t step;      /* growth step; parts of one step appear together */
+    const char* glyph;  /* UTF-8 grapheme cluster for leaves, NULL when codepoint is the whole glyph */
+} hbonsai_part;
+
+typedef struct hbonsai_generator hbonsai_generator;
+
+int hbonsai_api_version(void);
+
+void hbonsai_options_init(hbonsai_options* options);
+
+/* Returns NULL if options is NULL or out of range. The options and the
+ * strings they point to are copied. */
+hbonsai_generator* hbonsai_create(const hbonsai_options* options);
+
+/* Grows the next tree for a rows x cols screen, pot included, replacing the
+ * previous one. Successive calls with one seed give the same sequence of
+ * trees as infinite mode. Returns the number of parts, or -1 if the size is
+ * not positive. */
+long hbonsai_generate(hbonsai_generator* generator, int rows, int cols);
+
+/* Returns NULL if the current tree grew in full, or the name of the budget
+ * that cut it short: "parts", "branches", "memory" or "time". The tree is
+ * still complete-looking and can be rendered as usual. */
+const char* hbonsai_truncated(const hbonsai_generator* generator);
+
+/* Copies up to capacity parts of the current tree into parts and returns the
+ * total number of parts. Glyph pointers stay valid until hbonsai_free(). */
+size_t hbonsai_get_parts(const hbonsai_generator* generator, hbonsai_part* parts, size_t capacity);
+
+/* Writes the current tree, pot and message as 256-colour ANSI text, like
+ * --print, with snprintf semantics: at most size - 1 bytes plus a NUL, and
+ * the return value is the full length excluding the NUL. */
+size_t hbonsai_render_ansi(const hbonsai_generator* generator, char* out, size_t size);
+
+void hbonsai_free(hbonsai_generator* generator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HBONSAI_HBONSAI_H */
@@ -0,0 +1,16 @@
+#ifndef HBONSAI_INPUT_H
+#define HBONSAI_INPUT_H
+
+namespace hbonsai {
+
+// Terminal-library-neutral key event, translated by the Renderer.
+enum class KeyCode { Character, Left, Right, Up, Down, Home, End, Enter, Escape, Other };
+
+struct InputEvent {
+    KeyCode code = KeyCode::Other;
+    char32_t ch = 0; // set for KeyCode::Character
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_INPUT_H
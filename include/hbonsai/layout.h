@@ -0,0 +1,41 @@
+#ifndef HBONSAI_LAYOUT_H
+#define HBONSAI_LAYOUT_H
+
+#include "config.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hbonsai {
+
+// Palette index used for the pot outline, message and title text.
+constexpr int kTextColor = 7;
+
+// One run of text in the ascii-art pot, relative to the pot's top-left corner.
+struct BaseSegment {
+    int row = 0;
+    int col = 0;
+    const wchar_t* text = L"";
+    int colorIndex = kTextColor;
+    bool bold = false;
+};
+
+// Returns {height, width} of the pot for the given base type ({0, 0} for none).
+std::pair<int, int> base_dimensions(int baseType);
+
+// Returns the pot as a list of coloured runs, in drawing order.
+std::vector<BaseSegment> base_segments(const BonsaiConfig& config);
+
+// Returns the screen {y, x} of the pot's top-left corner.
+std::pair<int, int> base_origin(const BonsaiConfig& config, int rows, int cols);
+
+// Returns the screen {y, x} at which the message starts.
+std::pair<int, int> message_position(const BonsaiConfig& config, int rows, int cols);
+
+// Returns the screen {y, x} at which the title starts.
+std::pair<int, int> title_position(const std::string& text, int rows, int cols);
+
+} // namespace hbonsai
+
+#endif // HBONSAI_LAYOUT_H
@@ -0,0 +1,72 @@
+#ifndef HBONSAI_MERSENNE_H
+#define HBONSAI_MERSENNE_H
+
+#include <array>
+#include <cstdint>
+
+namespace hbonsai {
+
+// The same sequence as std::mt19937 for the same seed, made a block at a
+// time. The twist is split at the points where its look-ahead wraps, so each
+// loop reads only words it has not written (or finished writing long ago) and
+// the compiler can vectorize it; tempering happens for the whole block at once
+// instead of per draw. Satisfies UniformRandomBitGenerator, so standard
+// distributions give the same results over it as over std::mt19937.
+class BlockMt19937 {
+public:
+    using result_type = std::uint32_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xffffffffu; }
+
+    explicit BlockMt19937(result_type seed) {
+        state_[0] = seed;
+        for (std::uint32_t i = 1; i < kWords; ++i) {
+            state_[i] = 1812433253u * (state_[i - 1] ^ (state_[i - 1] >> 30)) + i;
+        }
+    }
+
+    result_type operator()() {
+        if (index_ == kWords) {
+            refill();
+        }
+        return block_[index_++];
+    }
+
+private:
+    static constexpr std::uint32_t kWords = 624;
+    static constexpr std::uint32_t kShift = 397;
+
+    static result_type twist(result_type upper, result_type lower, result_type far) {
+        result_type y = (upper & 0x80000000u) | (lower & 0x7fffffffu);
+        return far ^ (y >> 1) ^ ((0u - (y & 1u)) & 0x9908b0dfu);
+    }
+
+    void refill() {
+        for (std::uint32_t i = 0; i < kWords - kShift; ++i) {
+            state_[i] = twist(state_[i], state_[i + 1], state_[i + kShift]);
+        }
+        for (std::uint32_t i = kWords - kShift; i < kWords - 1; ++i) {
+            state_[i] = twist(state_[i], state_[i + 1], state_[i + kShift - kWords]);
+        }
+        state_[kWords - 1] = twist(state_[kWords - 1], state_[0], state_[kShift - 1]);
+
+        for (std::uint32_t i = 0; i < kWords; ++i) {
+            result_type y = state_[i];
+            y ^= y >> 11;
+            y ^= (y << 7) & 0x9d2c5680u;
+            y ^= (y << 15) & 0xefc60000u;
+            y ^= y >> 18;
+            block_[i] = y;
+        }
+        index_ = 0;
+    }
+
+    std::array<result_type, kWords> state_;
+    std::array<result_type, kWords> block_;
+    std::uint32_t index_ = kWords;
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_MERSENNE_H
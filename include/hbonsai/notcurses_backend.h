@@ -0,0 +1,58 @@
+#ifndef HBONSAI_NOTCURSES_BACKEND_H
+#define HBONSAI_NOTCURSES_BACKEND_H
+
+#include "render_backend.h"
+#include "termcaps.h"
+
+#include <cstdio>
+
+// Forward-declare notcurses types to keep the header clean
+struct notcurses;
+struct ncplane;
+struct ncpalette;
+
+namespace hbonsai {
+
+class NotcursesBackend : public RenderBackend {
+public:
+    // Renders to out, or to stdout when null. notcurses reads terminal
+    // replies from stdin, so out and stdin should be the same terminal.
+    explicit NotcursesBackend(std::FILE* out = nullptr);
+    ~NotcursesBackend() override;
+
+    bool isInitialized() const override;
+    std::pair<int, int> dimensions() const override;
+    void prepareFrame(const BonsaiConfig& config) override;
+    void drawStatic(const std::vector<TreePart>& parts, const BonsaiConfig& config) override;
+    void drawLive(const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                  const BonsaiConfig& config) override;
+    void drawCells(const std::vector<TreePart>& cells, const BonsaiConfig& config) override;
+    void renderTitle(const TitleConfig& config) override;
+    bool setPalette(const std::vector<PaletteEntry>& entries) override;
+    bool canSetPalette() const override;
+    void render() override;
+    void wait() override;
+    bool pollInput(InputEvent& event) override;
+    int inputFd() const override;
+    BackendStats stats() const override;
+
+    // What notcurses detected while initialising.
+    TerminalCaps capabilities() const;
+
+private:
+    struct notcurses* nc_ = nullptr;
+    struct ncplane* stdplane_ = nullptr;
+    struct ncpalette* palette_ = nullptr;
+    bool initialized_ = false;
+    double startupMs_ = 0.0;
+
+    void setPlaneColor(int colorIndex, bool bold);
+    void drawPart(const TreePart& part);
+    void drawTree(const std::vector<TreePart>& parts, const BonsaiConfig& config, int rows, int cols);
+    void drawBase(const BonsaiConfig& config, int rows, int cols);
+    void drawMessage(const BonsaiConfig& config, int rows, int cols);
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_NOTCURSES_BACKEND_H
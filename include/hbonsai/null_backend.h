@@ -0,0 +1,58 @@
+#ifndef HBONSAI_NULL_BACKEND_H
+#define HBONSAI_NULL_BACKEND_H
+
+#include "render_backend.h"
+
+#include <deque>
+
+namespace hbonsai {
+
+// Headless backend for tools: draws nothing, counts every call and replays
+// scripted key presses.
+class NullBackend : public RenderBackend {
+public:
+    struct Calls {
+        long long prepareFrame = 0;
+        long long drawStatic = 0;
+        long long drawLive = 0;
+        long long partsDrawn = 0;
+        long long drawCells = 0;
+        long long cellsDrawn = 0;
+        long long renderTitle = 0;
+        long long setPalette = 0;
+        long long render = 0;
+        long long wait = 0;
+    };
+
+    explicit NullBackend(int rows = 24, int cols = 80) : rows_(rows), cols_(cols) {}
+
+    bool isInitialized() const override { return true; }
+    std::pair<int, int> dimensions() const override { return {rows_, cols_}; }
+    void prepareFrame(const BonsaiConfig& config) override;
+    void drawStatic(const std::vector<TreePart>& parts, const BonsaiConfig& config) override;
+    void drawLive(const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                  const BonsaiConfig& config) override;
+    void drawCells(const std::vector<TreePart>& cells, const BonsaiConfig& config) override;
+    void renderTitle(const TitleConfig& config) override;
+    bool setPalette(const std::vector<PaletteEntry>& entries) override;
+    bool canSetPalette() const override { return true; }
+    void render() override;
+    void wait() override;
+    bool pollInput(InputEvent& event) override;
+    int inputFd() const override { return -1; }
+    BackendStats stats() const override;
+
+    const Calls& calls() const { return calls_; }
+    // Queues a key press for the next pollInput().
+    void pushInput(const InputEvent& event) { input_.push_back(event); }
+
+private:
+    int rows_;
+    int cols_;
+    Calls calls_;
+    std::deque<InputEvent> input_;
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_NULL_BACKEND_H
@@ -0,0 +1,52 @@
+#ifndef HBONSAI_PACING_H
+#define HBONSAI_PACING_H
+
+#include <cstddef>
+
+#include "render_backend.h"
+
+namespace hbonsai {
+
+// What the live-mode pacer did for the last tree, for the --verbose report.
+struct PaceStats {
+    double targetSeconds = 0.0;  // growth time aimed for
+    double grownSeconds = 0.0;   // growth time the tree actually took
+    long long frames = 0;        // frames that released parts
+    double partsPerFrame = 0.0;  // mean batch size
+    double intervalMs = 0.0;     // frame spacing at the end of growth
+    double renderMs = 0.0;       // smoothed terminal cost of one frame
+    double bytesPerFrame = 0.0;  // smoothed output per frame
+};
+
+// Adaptive live-mode pacing (--pace). Parts are released along a straight
+// line from none to all over the target time, but frames are only produced
+// as fast as the terminal can take them: the frame interval follows the
+// measured cost of getting a frame on screen, and each frame releases
+// however many parts the schedule has reached by then. A slow link gets
+// fewer, bigger frames; the tree still finishes on time.
+class GrowthPacer {
+public:
+    // Starts a tree of `total` parts that should take `targetSeconds`.
+    void reset(std::size_t total, double targetSeconds);
+    // Moves the schedule to `released` parts, after a seek.
+    void seek(std::size_t released);
+    // Advances by dt with the terminal's current frame cost. Returns the
+    // number of parts that should be on screen after this frame, or
+    // `released` if no frame is due yet.
+    std::size_t advance(double dt, std::size_t released, const FrameCost& cost);
+
+    const PaceStats& stats() const { return stats_; }
+
+private:
+    std::size_t total_ = 0;
+    double target_ = 0.0;
+    double elapsed_ = 0.0;
+    double sinceFrame_ = 0.0;
+    double interval_ = 0.0;
+    std::size_t released_ = 0;
+    PaceStats stats_;
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_PACING_H
@@ -0,0 +1,59 @@
+#ifndef HBONSAI_PART_INDEX_H
+#define HBONSAI_PART_INDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace hbonsai {
+
+struct TreePart;
+
+// Row-bucketed index over a generated tree. Parts are grouped by row in CSR
+// form: rowOffsets_[y] .. rowOffsets_[y + 1] are the runs of row y, and each
+// run is a stretch of consecutive part indices on that row. Consecutive parts
+// share a row often enough that this costs roughly 2 bytes per part.
+//
+// Parts outside rows [0, rows) are not indexed.
+class PartIndex {
+public:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    void build(const std::vector<TreePart>& parts, int rows);
+    void clear();
+
+    int rows() const { return rows_; }
+    std::size_t memoryUsage() const;
+
+    // Calls visit(index) for every part on rows [top, bottom], row by row and
+    // in growth order within a row. Costs O(rows + hits).
+    template <class Visit>
+    void forEachInRows(int top, int bottom, Visit&& visit) const {
+        top = std::max(top, 0);
+        bottom = std::min(bottom, rows_ - 1);
+        for (int row = top; row <= bottom; ++row) {
+            for (std::uint32_t run = rowOffsets_[row]; run < rowOffsets_[row + 1]; ++run) {
+                std::size_t first = runStart_[run];
+                for (std::size_t index = first; index < first + runLength_[run]; ++index) {
+                    visit(index);
+                }
+            }
+        }
+    }
+
+    // Index of the last part drawn over cell (y, x), or npos if none covers it.
+    // `parts` must be the vector the index was built from.
+    std::size_t topmost(const std::vector<TreePart>& parts, int y, int x) const;
+
+private:
+    int rows_ = 0;
+    std::vector<std::uint32_t> rowOffsets_; // rows_ + 1 offsets into the run arrays
+    std::vector<std::uint32_t> runStart_;   // first part index of each run
+    std::vector<std::uint8_t> runLength_;   // parts in each run; long runs are split
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_PART_INDEX_H
@@ -0,0 +1,70 @@
+#ifndef HBONSAI_PARTICLES_H
+#define HBONSAI_PARTICLES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "bonsai.h"
+
+namespace hbonsai {
+
+// Leaves that drop off a finished tree, drift in the wind and pile up on the
+// pot (the bottom row of the tree area). The pool has a fixed capacity and
+// stores particles as parallel arrays; nothing is allocated per particle.
+// Physics advances in fixed steps regardless of frame rate, and each frame
+// reports only the cells a particle left or entered.
+class LeafParticles {
+public:
+    explicit LeafParticles(int capacity);
+
+    // Takes spawn points and glyphs from the tree's leaves. `parts` must stay
+    // alive until the next build(); only colours may change in between.
+    // `index` is the tree's row index (Bonsai::lastIndex()).
+    void build(const std::vector<TreePart>& parts, const PartIndex& index, int rows, int cols);
+
+    // Advances the simulation by dt seconds and appends changed cells to dirty.
+    void step(double dt, std::vector<TreePart>& dirty);
+
+    // Appends every settled and falling leaf, for after the whole tree was
+    // redrawn. Scans the whole area, so it is not meant for every frame.
+    void redraw(std::vector<TreePart>& dirty) const;
+
+    std::size_t capacity() const { return posX_.size(); }
+    std::size_t alive() const { return alive_; }
+
+private:
+    void spawn();
+    void integrate(float h);
+    void despawn(std::size_t slot, std::vector<TreePart>& dirty);
+    void enter(int cell, std::uint32_t glyph, std::vector<TreePart>& dirty);
+    void leave(int cell, std::vector<TreePart>& dirty);
+    void drawBackground(int cell, std::vector<TreePart>& dirty) const;
+
+    const std::vector<TreePart>* parts_ = nullptr;
+    int rows_ = 0;
+    int cols_ = 0;
+    double accumulator_ = 0.0;
+    double spawnCredit_ = 0.0;
+    float time_ = 0.0f;
+    std::minstd_rand rng_{1};
+
+    // Particle pool, structure-of-arrays; slots [0, alive_) are live.
+    std::vector<float> posX_;
+    std::vector<float> posY_;
+    std::vector<float> velY_;
+    std::vector<float> phase_;
+    std::vector<std::uint32_t> glyph_; // index of the source leaf in *parts_
+    std::vector<std::int32_t> cell_;   // cell the particle is drawn in
+    std::size_t alive_ = 0;
+
+    std::vector<std::uint32_t> sources_;    // single-column leaf parts
+    std::vector<std::uint32_t> background_; // per cell: part index | flags, see Particles.cpp
+    std::vector<std::uint16_t> crowd_;      // per cell: particles drawn there
+    std::vector<std::int32_t> floor_;       // per column: first row a particle cannot enter
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_PARTICLES_H
@@ -0,0 +1,70 @@
+#ifndef HBONSAI_PHILOX_H
+#define HBONSAI_PHILOX_H
+
+#include <array>
+#include <cstdint>
+
+namespace hbonsai {
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3"). Every (key, stream) pair is an independent
+// sequence, so any number of streams can be drawn from concurrently and in
+// any order without changing their values.
+class PhiloxStream {
+public:
+    PhiloxStream(std::uint64_t key, std::uint64_t stream) : key_(key), stream_(stream) {}
+
+    std::uint32_t next() {
+        if (index_ == 4) {
+            block_ = generate(blockCounter_++);
+            index_ = 0;
+        }
+        return block_[index_++];
+    }
+
+    // Uniform integer in [0, max) using Lemire's multiply-shift reduction.
+    int roll(int max) {
+        if (max <= 0) {
+            return 0;
+        }
+        return static_cast<int>((static_cast<std::uint64_t>(next()) * static_cast<std::uint32_t>(max)) >> 32);
+    }
+
+private:
+    std::array<std::uint32_t, 4> generate(std::uint64_t block) const {
+        std::array<std::uint32_t, 4> ctr = {
+            static_cast<std::uint32_t>(stream_), static_cast<std::uint32_t>(stream_ >> 32),
+            static_cast<std::uint32_t>(block), static_cast<std::uint32_t>(block >> 32)};
+        std::uint32_t k0 = static_cast<std::uint32_t>(key_);
+        std::uint32_t k1 = static_cast<std::uint32_t>(key_ >> 32);
+
+        for (int round = 0; round < 10; ++round) {
+            std::uint64_t p0 = static_cast<std::uint64_t>(0xD2511F53u) * ctr[0];
+            std::uint64_t p1 = static_cast<std::uint64_t>(0xCD9E8D57u) * ctr[2];
+            ctr = {static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ k0, static_cast<std::uint32_t>(p1),
+                   static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ k1, static_cast<std::uint32_t>(p0)};
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        return ctr;
+    }
+
+    std::uint64_t key_;
+    std::uint64_t stream_;
+    std::uint64_t blockCounter_ = 0;
+    std::array<std::uint32_t, 4> block_{};
+    int index_ = 4;
+};
+
+// Derives the stream id of a child from its parent's id and its ordinal,
+// so a branch's stream depends only on its path from the trunk.
+constexpr std::uint64_t child_stream(std::uint64_t parent, std::uint64_t ordinal) {
+    std::uint64_t z = parent + 0x9E3779B97F4A7C15ull * (ordinal + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+} // namespace hbonsai
+
+#endif // HBONSAI_PHILOX_H
@@ -0,0 +1,80 @@
+#ifndef HBONSAI_RENDER_BACKEND_H
+#define HBONSAI_RENDER_BACKEND_H
+
+#include "bonsai.h"
+#include "config.h"
+#include "input.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace hbonsai {
+
+// Counters a backend keeps about its own output, shown with --verbose.
+struct BackendStats {
+    const char* name = "";
+    double startupMs = 0.0; // time spent in the backend's constructor
+    long long frames = 0;   // render() calls that wrote to the terminal
+    long long bytes = 0;    // bytes written to the terminal
+    double firstFrameMs = 0.0; // from Renderer construction to the end of the first render()
+    bool capsCached = false;   // BackendKind::Auto found this terminal in the capability cache
+    int outputs = 1;             // terminals written to; more than one with --broadcast
+    long long framesSkipped = 0; // broadcast: frames an output missed while still writing an earlier one
+    long long keyframes = 0;     // broadcast: full redraws sent to outputs that had fallen behind
+    long long framesMerged = 0;  // frames folded into a later one because the terminal was still busy
+};
+
+// Smoothed cost of getting one frame onto the terminal, used for pacing.
+struct FrameCost {
+    double seconds = 0.0; // drawing plus render(), as seen by the thread doing it
+    double bytes = 0.0;   // bytes written per frame
+};
+
+// One terminal palette slot to reprogram; rgb is 0xRRGGBB.
+struct PaletteEntry {
+    int index = 0;
+    std::uint32_t rgb = 0;
+};
+
+// Terminal output behind Renderer. Coordinates are screen cells; the tree area
+// is everything above the pot.
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    virtual bool isInitialized() const = 0;
+    virtual std::pair<int, int> dimensions() const = 0;
+    // Clears the screen to the pot and message.
+    virtual void prepareFrame(const BonsaiConfig& config) = 0;
+    virtual void drawStatic(const std::vector<TreePart>& parts, const BonsaiConfig& config) = 0;
+    // Draws parts[i] for every i in indices, then the message once.
+    virtual void drawLive(const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                          const BonsaiConfig& config) = 0;
+    // Draws standalone cells for effects; a part with colorIndex < 0 blanks
+    // its cell. Clipped to the tree area like drawLive.
+    virtual void drawCells(const std::vector<TreePart>& cells, const BonsaiConfig& config) = 0;
+    virtual void renderTitle(const TitleConfig& config) = 0;
+    // Redefines palette slots so cells already drawn with them change colour
+    // without being redrawn. Returns false if the terminal cannot do that.
+    virtual bool setPalette(const std::vector<PaletteEntry>& entries) = 0;
+    // Whether setPalette() can work on this terminal, without changing anything.
+    virtual bool canSetPalette() const = 0;
+    // Pushes everything drawn since the last call to the terminal.
+    virtual void render() = 0;
+    // Blocks until everything passed to render() has been written. Backends
+    // that write from render() itself have nothing to wait for.
+    virtual void flush() {}
+    // Backends that measure their frames report it here; zero means unknown.
+    virtual FrameCost frameCost() const { return {}; }
+    virtual void wait() = 0;
+    virtual bool pollInput(InputEvent& event) = 0;
+    // Descriptor that becomes readable when input arrives, or -1 if none.
+    virtual int inputFd() const = 0;
+    virtual BackendStats stats() const = 0;
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_RENDER_BACKEND_H
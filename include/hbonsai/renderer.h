@@ -3,42 +3,57 @@
 
 #include "bonsai.h"
 #include "config.h"
+#include "input.h"
+#include "render_backend.h"
 
+#include <chrono>
+#include <cstddef>
+#include <memory>
 #include <utility>
 #include <vector>
 
-// Forward-declare notcurses types to keep the header clean
-struct notcurses;
-struct ncplane;
-
 namespace hbonsai {
 
+// What scenes draw through. Forwards to the terminal backend picked with
+// --backend, behind a writer thread; scenes never see which one it is.
 class Renderer {
 public:
-    Renderer();
+    explicit Renderer(const AppConfig& appConfig);
+    explicit Renderer(std::unique_ptr<RenderBackend> backend);
     ~Renderer();
 
     bool isInitialized() const;
     std::pair<int, int> dimensions() const;
     void prepareFrame(const BonsaiConfig& config);
     void drawStatic(const std::vector<TreePart>& parts, const BonsaiConfig& config);
-    void drawLive(const TreePart& part, const BonsaiConfig& config);
+    // Draws parts[i] for every i in indices, then the message once.
+    void drawLive(const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                  const BonsaiConfig& config);
+    // Effect cells; colorIndex < 0 blanks a cell.
+    void drawCells(const std::vector<TreePart>& cells, const BonsaiConfig& config);
     void renderTitle(const TitleConfig& config);
+    bool setPalette(const std::vector<PaletteEntry>& entries);
     void render();
+    // Blocks until every rendered frame is on the terminal.
+    void flush();
+    // Measured cost of a frame on the terminal; zero until one was written.
+    FrameCost frameCost() const;
     void wait(); // Wait for input
+    // Returns the next pending key press without blocking; false if there is none.
+    bool pollInput(InputEvent& event);
+    int inputFd() const;
+    BackendStats stats() const;
 
     static int baseHeightForType(int baseType);
 
 private:
-    struct notcurses* nc_;
-    struct ncplane* stdplane_;
-    bool initialized_ = false;
-
-    void setPlaneColor(int colorIndex, bool bold);
-    void drawTree(const std::vector<TreePart>& parts, const BonsaiConfig& config, int rows, int cols);
-    void drawBase(const BonsaiConfig& config, int rows, int cols);
-    void drawMessage(const BonsaiConfig& config, int rows, int cols);
-    std::pair<int, int> baseDimensions(int baseType) const;
+    void createBackend(const AppConfig& appConfig);
+    void createAutoBackend(const AppConfig& appConfig);
+
+    std::unique_ptr<RenderBackend> backend_;
+    std::chrono::steady_clock::time_point created_ = std::chrono::steady_clock::now();
+    double firstFrameMs_ = 0.0;
+    bool capsCached_ = false;
 };
 
 } // namespace hbonsai
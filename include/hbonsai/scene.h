@@ -1,6 +1,8 @@
 #ifndef HBONSAI_SCENE_H
 #define HBONSAI_SCENE_H
 
+#include "hbonsai/input.h"
+
 namespace hbonsai {
 
 class Renderer;
@@ -10,6 +12,7 @@ public:
     virtual ~Scene() = default;
 
     virtual void onEnter(Renderer& renderer) { (void)renderer; }
+    virtual void onInput(const InputEvent& event) { (void)event; }
     virtual void update(double dt) = 0;
     virtual void draw(Renderer& renderer) = 0;
     virtual bool isFinished() const = 0;
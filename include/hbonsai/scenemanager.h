@@ -2,8 +2,10 @@
 #define HBONSAI_SCENEMANAGER_H
 
 #include <deque>
+#include <functional>
 #include <memory>
 
+#include "hbonsai/clock.h"
 #include "hbonsai/config.h"
 #include "hbonsai/scene.h"
 
@@ -13,11 +15,24 @@ class Renderer;
 
 class SceneManager {
 public:
+    // Called once per frame, after rendering, with the clock's current time.
+    using FrameHook = std::function<void(double now)>;
+
     void addScene(std::unique_ptr<Scene> scene);
     void run(Renderer& renderer, const AppConfig& appConfig);
+    void run(Renderer& renderer, const AppConfig& appConfig, Clock& clock);
+    // Makes run() return after the current frame.
+    void requestStop() { stopRequested_ = true; }
+    // True if run() returned because of a key press: a quit key, or a key
+    // that made the last scene finish.
+    bool quitByUser() const { return quitByUser_; }
+    void setFrameHook(FrameHook hook) { frameHook_ = std::move(hook); }
 
 private:
     std::deque<std::unique_ptr<Scene>> scenes_;
+    FrameHook frameHook_;
+    bool stopRequested_ = false;
+    bool quitByUser_ = false;
 };
 
 } // namespace hbonsai
@@ -0,0 +1,52 @@
+#ifndef HBONSAI_SEASONS_H
+#define HBONSAI_SEASONS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bonsai.h"
+#include "render_backend.h"
+
+namespace hbonsai {
+
+class Renderer;
+
+// Colours for the four BonsaiConfig::colors roles (dark leaves, dark wood,
+// light leaves, light wood) at `phase` through the year, 0 <= phase < 1.
+std::array<std::uint32_t, 4> season_colors(double phase);
+
+// Index of the closest colour in the fixed xterm 256-colour palette.
+int nearest_xterm_index(std::uint32_t rgb);
+
+// Cycles the tree through the seasons. Where the terminal palette can be
+// reprogrammed, each change rewrites the four configured palette entries, so
+// the cost is the same for any tree. Otherwise parts are recoloured to the
+// nearest fixed-palette index and redrawn, but only when that index changes.
+class SeasonCycle {
+public:
+    SeasonCycle(double period, const std::array<int, 4>& indices);
+
+    // Records which role each part of a new tree has.
+    void reset(const std::vector<TreePart>& parts);
+    void advance(double dt);
+
+    // Shows the current season. In fallback mode recolours `parts`, appends
+    // the first `drawn` of them to dirty for redrawing and returns true.
+    bool apply(Renderer& renderer, std::vector<TreePart>& parts, std::size_t drawn, std::vector<TreePart>& dirty);
+
+private:
+    double period_;
+    std::array<int, 4> indices_;
+    double time_ = 0.0;
+    bool fallback_ = false;
+    std::array<std::uint32_t, 4> applied_{};
+    bool hasApplied_ = false;
+    std::array<int, 4> fallbackIndices_{};
+    std::vector<std::uint8_t> roles_; // per part: role 0-3, or kNoRole
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_SEASONS_H
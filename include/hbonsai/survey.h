@@ -0,0 +1,25 @@
+#ifndef HBONSAI_SURVEY_H
+#define HBONSAI_SURVEY_H
+
+#include "config.h"
+
+namespace hbonsai {
+
+// Runs --survey: grows config.app.survey trees with consecutive seeds from
+// --seed (or 1), on every core, counting them instead of drawing them, and
+// prints the distributions of their size, part and branch counts, or one CSV
+// row per tree with --survey-csv. Counting a tree is about 2.6 times faster
+// than generating it, not 10: both make the same random draws, and those
+// take most of the time.
+// Returns the exit code.
+int run_survey(const Config& config);
+
+// Runs --find-seed: scans seeds from --seed (or 1) on every core for trees
+// that meet every constraint in config.app.findSeed, stops once
+// config.app.findCount have been found, and prints them as CSV rows.
+// Returns the exit code.
+int run_find_seed(const Config& config);
+
+} // namespace hbonsai
+
+#endif // HBONSAI_SURVEY_H
@@ -0,0 +1,33 @@
+#ifndef HBONSAI_TERMCAPS_H
+#define HBONSAI_TERMCAPS_H
+
+#include <string>
+
+namespace hbonsai {
+
+// What notcurses found out about a terminal, remembered across launches so
+// later runs can skip the interrogation.
+struct TerminalCaps {
+    bool utf8 = false;
+    unsigned paletteSize = 0;
+    bool truecolor = false;
+    std::string name; // as reported by notcurses_detected_terminal()
+};
+
+// Identifies "the same kind of terminal" from the environment: $TERM, the
+// emulator's own variables and the locale's codeset.
+std::string terminal_identity();
+
+// Returns $XDG_CACHE_HOME/hbonsai-termcaps, next to the cbonsai save file.
+std::string default_termcaps_path();
+
+// Looks up identity in the cache file. Returns false on a miss or if the file
+// is missing or unreadable.
+bool load_terminal_caps(const std::string& path, const std::string& identity, TerminalCaps& caps);
+
+// Records caps for identity, replacing any older entry for it.
+bool store_terminal_caps(const std::string& path, const std::string& identity, const TerminalCaps& caps);
+
+} // namespace hbonsai
+
+#endif // HBONSAI_TERMCAPS_H
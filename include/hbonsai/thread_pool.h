@@ -0,0 +1,57 @@
+#ifndef HBONSAI_THREAD_POOL_H
+#define HBONSAI_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hbonsai {
+
+// A small work-stealing pool for recursive fork/join work. Each worker pops
+// its own queue LIFO (depth-first, cache friendly) and steals FIFO from the
+// others (oldest, usually largest, tasks first). Tasks may submit more tasks.
+class WorkStealingPool {
+public:
+    // threads == 0 selects std::thread::hardware_concurrency().
+    explicit WorkStealingPool(unsigned threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(threads_.size()) + 1; }
+
+    void submit(std::function<void()> task);
+
+    // Runs tasks on the calling thread until every submitted task has finished.
+    void wait();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool runOne(std::size_t self);
+    void workerLoop(std::size_t index);
+
+    std::vector<std::unique_ptr<Queue>> queues_; // one per worker, plus one for the caller
+    std::vector<std::thread> threads_;
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<std::size_t> nextQueue_{0};
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    bool stopping_ = false;
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_THREAD_POOL_H
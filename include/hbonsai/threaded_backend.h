@@ -0,0 +1,93 @@
+#ifndef HBONSAI_THREADED_BACKEND_H
+#define HBONSAI_THREADED_BACKEND_H
+
+#include "render_backend.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hbonsai {
+
+// Moves a backend's terminal output onto a writer thread, so the frame loop
+// never waits for a slow terminal.
+//
+// Draw calls are recorded into the frame being built; render() hands it over
+// through a single-slot mailbox. If the writer is still busy with an earlier
+// frame, the new one is merged into the frame already waiting rather than
+// queued behind it: the terminal skips straight to the latest picture. A
+// frame that clears the screen drops whatever drawing it was merged onto, so
+// the waiting frame never grows past one screen's worth.
+//
+// Only the writer thread draws and renders through the wrapped backend.
+// Input, which every backend reads independently of its output, stays on the
+// caller's thread.
+class ThreadedBackend : public RenderBackend {
+public:
+    explicit ThreadedBackend(std::unique_ptr<RenderBackend> backend);
+    ~ThreadedBackend() override;
+
+    ThreadedBackend(const ThreadedBackend&) = delete;
+    ThreadedBackend& operator=(const ThreadedBackend&) = delete;
+
+    bool isInitialized() const override;
+    std::pair<int, int> dimensions() const override;
+    void prepareFrame(const BonsaiConfig& config) override;
+    void drawStatic(const std::vector<TreePart>& parts, const BonsaiConfig& config) override;
+    void drawLive(const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                  const BonsaiConfig& config) override;
+    void drawCells(const std::vector<TreePart>& cells, const BonsaiConfig& config) override;
+    void renderTitle(const TitleConfig& config) override;
+    bool setPalette(const std::vector<PaletteEntry>& entries) override;
+    bool canSetPalette() const override;
+    void render() override;
+    void flush() override;
+    FrameCost frameCost() const override;
+    void wait() override;
+    bool pollInput(InputEvent& event) override;
+    int inputFd() const override;
+    BackendStats stats() const override;
+
+private:
+    // One recorded draw call. Configs are held by pointer: like the parts'
+    // grapheme clusters, they must outlive the frame, which flush() ensures.
+    struct Command {
+        enum class Kind { Prepare, Static, Cells, Title, Palette };
+        Kind kind = Kind::Cells;
+        const BonsaiConfig* config = nullptr;
+        std::vector<TreePart> parts;
+        TitleConfig title;
+        std::vector<PaletteEntry> palette;
+    };
+    using Frame = std::vector<Command>;
+
+    void run();
+    void waitIdle() const;
+    void replay(const Frame& frame);
+    static void merge(Frame& waiting, Frame&& newer, std::pair<int, int> dimensions);
+    static void compact(Frame& frame, int rows, int cols);
+
+    std::unique_ptr<RenderBackend> backend_;
+    bool initialized_ = false;
+    bool canSetPalette_ = false;
+    std::pair<int, int> dimensions_;
+    Frame building_; // caller's thread only
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_; // a frame is waiting, or stop_
+    mutable std::condition_variable idle_; // the writer finished a frame
+    Frame mailbox_;
+    bool full_ = false;
+    bool busy_ = false;
+    bool stop_ = false;
+    long long merged_ = 0;
+    long long handedOver_ = 0;
+    FrameCost cost_; // moving average over the writer's frames
+    std::thread writer_;
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_THREADED_BACKEND_H
@@ -0,0 +1,56 @@
+#ifndef HBONSAI_TIMELINE_H
+#define HBONSAI_TIMELINE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bonsai.h"
+
+namespace hbonsai {
+
+// Seek index over a generated tree for live mode. Every interval() parts it
+// keeps a compact checkpoint: the indices of the parts visible on the canvas
+// at that point. Reconstructing the canvas after any number of parts then
+// costs one checkpoint plus at most interval() replayed parts.
+//
+// Checkpoint memory is bounded: when it would exceed the limit, every other
+// checkpoint is dropped and the interval doubles.
+class GrowthTimeline {
+public:
+    GrowthTimeline(std::size_t interval, std::size_t memoryLimit);
+
+    void build(const std::vector<TreePart>& parts, int rows, int cols);
+
+    std::size_t interval() const { return interval_; }
+    std::size_t memoryUsage() const { return memoryUsage_; }
+
+    // Calls draw(index) for every part needed to show the canvas as it is
+    // after the first `step` parts, in drawing order.
+    template <class Draw>
+    void replay(std::size_t step, Draw&& draw) const {
+        if (checkpoints_.empty()) {
+            return;
+        }
+        std::size_t checkpoint = std::min(step / interval_, checkpoints_.size() - 1);
+        for (std::uint32_t index : checkpoints_[checkpoint]) {
+            draw(static_cast<std::size_t>(index));
+        }
+        for (std::size_t index = checkpoint * interval_; index < step; ++index) {
+            draw(index);
+        }
+    }
+
+private:
+    void thin();
+
+    std::size_t interval_;
+    std::size_t memoryLimit_;
+    std::size_t memoryUsage_ = 0;
+    std::vector<std::vector<std::uint32_t>> checkpoints_;
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_TIMELINE_H
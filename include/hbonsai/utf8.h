@@ -0,0 +1,30 @@
+#ifndef HBONSAI_UTF8_H
+#define HBONSAI_UTF8_H
+
+#include <string>
+#include <vector>
+
+namespace hbonsai {
+
+// One extended grapheme cluster (what the user perceives as one character).
+struct Grapheme {
+    std::string utf8;      // the whole cluster, NUL-terminated via std::string
+    wchar_t first = L' ';  // its leading code point
+    int width = 1;         // terminal columns it occupies
+};
+
+// Decodes UTF-8 into wide characters, skipping malformed sequences.
+std::wstring utf8_to_wstring(const std::string& input);
+
+// Appends the UTF-8 encoding of a single code point.
+void append_utf8(std::string& output, char32_t codepoint);
+
+// Splits UTF-8 text into extended grapheme clusters and measures each one.
+// Covers combining marks, variation selectors, emoji modifiers, ZWJ sequences,
+// tag sequences and regional-indicator flags; this is a practical subset of
+// UAX #29, not the full rule set.
+std::vector<Grapheme> split_graphemes(const std::string& input);
+
+} // namespace hbonsai
+
+#endif // HBONSAI_UTF8_H
@@ -0,0 +1,61 @@
+#ifndef HBONSAI_WIND_H
+#define HBONSAI_WIND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bonsai.h"
+#include "part_index.h"
+
+namespace hbonsai {
+
+// Post-growth wind: single-column leaf glyphs sway one cell left or right of
+// where they grew, moving into empty cells or trading places with other
+// leaves. Each step looks at no more than `budget` leaves, so the cells it
+// changes -- and the cost of redrawing them -- do not grow with the tree.
+class WindEffect {
+public:
+    explicit WindEffect(int budget);
+
+    // Indexes the leaf cells of a finished tree drawn in a rows x cols area;
+    // `index` is the tree's row index (Bonsai::lastIndex()).
+    void build(const std::vector<TreePart>& parts, const PartIndex& index, int rows, int cols);
+
+    // Advances the wind by dt seconds and appends every cell whose content
+    // changed: moved leaves, and blanks (colorIndex -1) where they left.
+    void step(double dt, std::vector<TreePart>& dirty);
+
+    // Picks up new colours after parts were recoloured in place.
+    void recolor(const std::vector<TreePart>& parts);
+    // Appends every leaf where it is shown now, and blanks the homes of leaves
+    // that moved into empty cells, for after the whole tree was redrawn.
+    void redraw(std::vector<TreePart>& dirty) const;
+
+    std::size_t leafCount() const { return leaves_.size(); }
+
+private:
+    struct Leaf {
+        TreePart glyph;
+        std::uint32_t part = 0; // index in the parts passed to build()
+        int home = 0; // cell index the leaf grew in
+        int pos = 0;  // cell index it is shown in now
+    };
+
+    void show(const Leaf& leaf, std::vector<TreePart>& dirty) const;
+    void blank(int cell, std::vector<TreePart>& dirty) const;
+
+    int budget_;
+    int rows_ = 0;
+    int cols_ = 0;
+    double time_ = 0.0;
+    std::vector<Leaf> leaves_;
+    // Per cell: index into leaves_, or one of the markers in Wind.cpp.
+    std::vector<std::int32_t> occupant_;
+    std::size_t cursor_ = 0;
+    std::size_t stride_ = 1;
+};
+
+} // namespace hbonsai
+
+#endif // HBONSAI_WIND_H
@@ -0,0 +1,30 @@
+#include "hbonsai/alloc_stats.h"
+
+#include <atomic>
+
+namespace hbonsai {
+namespace {
+
+// Constant-initialised, so it is valid for allocations made by other
+// translation units' static constructors.
+constinit std::atomic<int> gPhase{static_cast<int>(AllocPhase::Startup)};
+
+constexpr std::array<const char*, kAllocPhaseCount> kPhaseNames = {
+    "startup", "config", "first-frame", "generation", "frames", "exit",
+};
+
+} // namespace
+
+void set_alloc_phase(AllocPhase phase) {
+    gPhase.store(static_cast<int>(phase), std::memory_order_relaxed);
+}
+
+AllocPhase alloc_phase() {
+    return static_cast<AllocPhase>(gPhase.load(std::memory_order_relaxed));
+}
+
+const char* alloc_phase_name(AllocPhase phase) {
+    return kPhaseNames[static_cast<std::size_t>(phase)];
+}
+
+} // namespace hbonsai
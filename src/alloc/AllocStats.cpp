@@ -0,0 +1,253 @@
+#include "hbonsai/alloc_stats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+namespace hbonsai {
+namespace {
+
+struct PhaseCounters {
+    std::atomic<long long> allocations{0};
+    std::atomic<long long> frees{0};
+    std::atomic<long long> bytes{0};
+    std::atomic<long long> peakBytes{0};
+};
+
+// All constant-initialised, so they work for allocations made by other
+// translation units' static constructors.
+constinit std::atomic<bool> gEnabled{true};
+constinit std::atomic<long long> gLiveBytes{0};
+constinit std::atomic<long long> gPeakBytes{0};
+constinit std::array<PhaseCounters, kAllocPhaseCount> gPhases{};
+
+// Frees do not say how big the block was, so both sides use what the
+// allocator reports instead of the requested size.
+std::size_t block_size(void* block) {
+#if defined(__APPLE__)
+    return malloc_size(block);
+#else
+    return malloc_usable_size(block);
+#endif
+}
+
+void raise_to(std::atomic<long long>& peak, long long value) {
+    long long seen = peak.load(std::memory_order_relaxed);
+    while (seen < value && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+PhaseCounters& current_phase() {
+    return gPhases[static_cast<std::size_t>(alloc_phase())];
+}
+
+void record_allocation(void* block) {
+    auto size = static_cast<long long>(block_size(block));
+    PhaseCounters& phase = current_phase();
+    phase.allocations.fetch_add(1, std::memory_order_relaxed);
+    phase.bytes.fetch_add(size, std::memory_order_relaxed);
+    long long live = gLiveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    raise_to(phase.peakBytes, live);
+    raise_to(gPeakBytes, live);
+}
+
+void record_free(void* block) {
+    PhaseCounters& phase = current_phase();
+    phase.frees.fetch_add(1, std::memory_order_relaxed);
+    // What an earlier phase left live counts towards this one's peak too.
+    long long live = gLiveBytes.fetch_sub(static_cast<long long>(block_size(block)), std::memory_order_relaxed);
+    raise_to(phase.peakBytes, live);
+}
+
+// operator new's contract: retry through the new handler until it gives up.
+void* allocate(std::size_t size, std::size_t alignment) {
+    if (size == 0) {
+        size = 1;
+    }
+    for (;;) {
+        void* block = alignment <= alignof(std::max_align_t)
+                          ? std::malloc(size)
+                          : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+        if (block != nullptr) {
+            if (gEnabled.load(std::memory_order_relaxed)) {
+                record_allocation(block);
+            }
+            return block;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* allocate_nothrow(std::size_t size, std::size_t alignment) noexcept {
+    try {
+        return allocate(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void release(void* block) noexcept {
+    if (block == nullptr) {
+        return;
+    }
+    if (gEnabled.load(std::memory_order_relaxed)) {
+        record_free(block);
+    }
+    std::free(block);
+}
+
+AllocCounts load(const PhaseCounters& counters) {
+    AllocCounts counts;
+    counts.allocations = counters.allocations.load(std::memory_order_relaxed);
+    counts.frees = counters.frees.load(std::memory_order_relaxed);
+    counts.bytes = counters.bytes.load(std::memory_order_relaxed);
+    counts.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+    return counts;
+}
+
+void print_json_counts(std::ostream& os, const AllocCounts& counts) {
+    os << "{\"allocations\":" << counts.allocations << ",\"frees\":" << counts.frees << ",\"bytes\":" << counts.bytes
+       << ",\"peak_bytes\":" << counts.peakBytes << "}";
+}
+
+void print_row(std::ostream& os, const char* name, const AllocCounts& counts) {
+    os << "  " << std::left << std::setw(12) << name << std::right << std::setw(12) << counts.allocations
+       << std::setw(12) << counts.frees << std::setw(14) << counts.bytes << std::setw(14) << counts.peakBytes << "\n";
+}
+
+} // namespace
+
+void stop_alloc_stats() {
+    gEnabled.store(false, std::memory_order_relaxed);
+}
+
+bool alloc_stats_enabled() {
+    return gEnabled.load(std::memory_order_relaxed);
+}
+
+AllocReport alloc_stats_report() {
+    AllocReport report;
+    for (std::size_t i = 0; i < kAllocPhaseCount; ++i) {
+        report.phases[i] = load(gPhases[i]);
+        report.total.allocations += report.phases[i].allocations;
+        report.total.frees += report.phases[i].frees;
+        report.total.bytes += report.phases[i].bytes;
+    }
+    report.total.peakBytes = gPeakBytes.load(std::memory_order_relaxed);
+    report.liveBytes = gLiveBytes.load(std::memory_order_relaxed);
+    return report;
+}
+
+void print_alloc_stats(std::ostream& os, const AllocReport& report, bool json) {
+    if (json) {
+        os << "{\"phases\":{";
+        for (std::size_t i = 0; i < kAllocPhaseCount; ++i) {
+            os << (i > 0 ? "," : "") << "\"" << alloc_phase_name(static_cast<AllocPhase>(i)) << "\":";
+            print_json_counts(os, report.phases[i]);
+        }
+        os << "},\"total\":";
+        print_json_counts(os, report.total);
+        os << ",\"live_bytes\":" << report.liveBytes << "}" << std::endl;
+        return;
+    }
+    os << "allocations:\n  " << std::left << std::setw(12) << "phase" << std::right << std::setw(12) << "allocs"
+       << std::setw(12) << "frees" << std::setw(14) << "bytes" << std::setw(14) << "peak bytes" << "\n";
+    for (std::size_t i = 0; i < kAllocPhaseCount; ++i) {
+        print_row(os, alloc_phase_name(static_cast<AllocPhase>(i)), report.phases[i]);
+    }
+    print_row(os, "total", report.total);
+    os << "  " << report.liveBytes << " bytes still live" << std::endl;
+}
+
+} // namespace hbonsai
+
+void* operator new(std::size_t size) {
+    return hbonsai::allocate(size, 0);
+}
+
+void* operator new[](std::size_t size) {
+    return hbonsai::allocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return hbonsai::allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return hbonsai::allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return hbonsai::allocate_nothrow(size, 0);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return hbonsai::allocate_nothrow(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return hbonsai::allocate_nothrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return hbonsai::allocate_nothrow(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* block) noexcept {
+    hbonsai::release(block);
+}
+
+void operator delete[](void* block) noexcept {
+    hbonsai::release(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept {
+    hbonsai::release(block);
+}
+
+void operator delete[](void* block, std::size_t) noexcept {
+    hbonsai::release(block);
+}
+
+void operator delete(void* block, std::align_val_t) noexcept {
+    hbonsai::release(block);
+}
+
+void operator delete[](void* block, std::align_val_t) noexcept {
+    hbonsai::release(block);
+}
+
+void operator delete(void* block, std::size_t, std::align_val_t) noexcept {
+    hbonsai::release(block);
+}
+
+void operator delete[](void* block, std::size_t, std::align_val_t) noexcept {
+    hbonsai::release(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) noexcept {
+    hbonsai::release(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) noexcept {
+    hbonsai::release(block);
+}
+
+void operator delete(void* block, std::align_val_t, const std::nothrow_t&) noexcept {
+    hbonsai::release(block);
+}
+
+void operator delete[](void* block, std::align_val_t, const std::nothrow_t&) noexcept {
+    hbonsai::release(block);
+}
@@ -0,0 +1,285 @@
+#include "hbonsai/ansi.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
+
+#include "hbonsai/layout.h"
+#include "hbonsai/utf8.h"
+
+namespace hbonsai {
+namespace {
+
+bool is_blank(const AnsiCanvas::Cell& cell) {
+    return cell.ch == L' ' && !cell.egc && !cell.continuation;
+}
+
+// Blank cells look the same whatever their attributes, since the background is
+// always the terminal default.
+bool same_cell(const AnsiCanvas::Cell& a, const AnsiCanvas::Cell& b) {
+    if (is_blank(a) || is_blank(b)) {
+        return is_blank(a) && is_blank(b);
+    }
+    if (a.ch != b.ch || a.colorIndex != b.colorIndex || a.bold != b.bold || a.continuation != b.continuation) {
+        return false;
+    }
+    if (a.egc == b.egc) {
+        return true;
+    }
+    return a.egc && b.egc && std::strcmp(a.egc, b.egc) == 0;
+}
+
+void append_cell(std::string& out, const AnsiCanvas::Cell& cell) {
+    if (cell.egc) {
+        out += cell.egc;
+    } else {
+        append_utf8(out, static_cast<char32_t>(cell.ch));
+    }
+}
+
+void compose_message(AnsiCanvas& canvas, const BonsaiConfig& config) {
+    if (config.message.empty()) {
+        return;
+    }
+
+    auto [msgY, msgX] = message_position(config, canvas.rows(), canvas.cols());
+    canvas.putText(msgY, msgX, utf8_to_wstring(config.message), kTextColor, true);
+}
+
+} // namespace
+
+AnsiCanvas::AnsiCanvas(int rows, int cols)
+    : rows_(std::max(0, rows)), cols_(std::max(0, cols)),
+      cells_(static_cast<size_t>(rows_) * static_cast<size_t>(cols_)) {}
+
+void AnsiCanvas::clear() {
+    std::fill(cells_.begin(), cells_.end(), Cell{});
+}
+
+int AnsiCanvas::put(int y, int x, wchar_t ch, int colorIndex, bool bold) {
+    int width = wcwidth(ch);
+    if (width <= 0) {
+        width = 1;
+    }
+    place(y, x, width, Cell{ch, nullptr, colorIndex, bold, false});
+    return width;
+}
+
+void AnsiCanvas::put(const TreePart& part) {
+    place(part.y, part.x, part.width, Cell{part.ch, part.egc, part.colorIndex, part.bold, false});
+}
+
+void AnsiCanvas::place(int y, int x, int width, const Cell& cell) {
+    if (y < 0 || y >= rows_ || x < 0 || x + width > cols_) {
+        return;
+    }
+
+    Cell* row = &cells_[static_cast<size_t>(y) * cols_];
+    // Overwriting either half of a wide character blanks the other half.
+    if (row[x].continuation && x > 0) {
+        row[x - 1] = Cell{};
+    }
+    if (x + width < cols_ && row[x + width].continuation) {
+        row[x + width] = Cell{};
+    }
+
+    row[x] = cell;
+    for (int i = 1; i < width; ++i) {
+        row[x + i] = Cell{L' ', nullptr, cell.colorIndex, cell.bold, true};
+    }
+}
+
+void AnsiCanvas::putText(int y, int x, const std::wstring& text, int colorIndex, bool bold) {
+    for (wchar_t ch : text) {
+        x += put(y, x, ch, colorIndex, bold);
+    }
+}
+
+void AnsiCanvas::encode(std::string& out) const {
+    out.reserve(out.size() + cells_.size() + static_cast<size_t>(rows_) * 16);
+
+    int currentColor = -1;
+    bool currentBold = false;
+    for (int y = 0; y < rows_; ++y) {
+        const Cell* row = &cells_[static_cast<size_t>(y) * cols_];
+
+        // Trailing blanks carry no information; drop them to keep the output small.
+        int end = cols_;
+        while (end > 0 && row[end - 1].ch == L' ' && !row[end - 1].continuation) {
+            --end;
+        }
+
+        for (int x = 0; x < end; ++x) {
+            const Cell& cell = row[x];
+            if (cell.continuation) {
+                continue;
+            }
+            if (cell.ch != L' ' && (cell.colorIndex != currentColor || cell.bold != currentBold)) {
+                append_sgr(out, cell.colorIndex, cell.bold);
+                currentColor = cell.colorIndex;
+                currentBold = cell.bold;
+            }
+            append_cell(out, cell);
+        }
+        out.push_back('\n');
+    }
+    out += "\033[0m";
+}
+
+void AnsiCanvas::encodeDiff(const AnsiCanvas& previous, std::string& out) const {
+    if (previous.rows_ != rows_ || previous.cols_ != cols_) {
+        return;
+    }
+
+    // Cursor and attribute state are unknown on entry: the first change always
+    // positions the cursor and sets attributes explicitly.
+    int cursorY = -1;
+    int cursorX = -1;
+    int currentColor = -2;
+    bool currentBold = false;
+    for (int y = 0; y < rows_; ++y) {
+        const Cell* row = &cells_[static_cast<size_t>(y) * cols_];
+        const Cell* before = &previous.cells_[static_cast<size_t>(y) * cols_];
+        for (int x = 0; x < cols_; ++x) {
+            const Cell& cell = row[x];
+            if (same_cell(cell, before[x])) {
+                continue;
+            }
+            if (cell.continuation) {
+                // Drawn along with the wide character to its left.
+                continue;
+            }
+
+            if (cursorY != y || cursorX != x) {
+                out += "\033[";
+                out += std::to_string(y + 1);
+                out.push_back(';');
+                out += std::to_string(x + 1);
+                out.push_back('H');
+            }
+            if (!is_blank(cell) && (cell.colorIndex != currentColor || cell.bold != currentBold)) {
+                append_sgr(out, cell.colorIndex, cell.bold);
+                currentColor = cell.colorIndex;
+                currentBold = cell.bold;
+            }
+            append_cell(out, cell);
+
+            int width = 1;
+            while (x + width < cols_ && row[x + width].continuation) {
+                ++width;
+            }
+            cursorY = y;
+            cursorX = x + width;
+        }
+    }
+}
+
+void append_sgr(std::string& out, int colorIndex, bool bold) {
+    out += bold ? "\033[0;1" : "\033[0";
+    if (colorIndex >= 16) {
+        out += ";38;5;";
+        out += std::to_string(colorIndex);
+    } else if (colorIndex >= 8) {
+        out += ";9";
+        out.push_back(static_cast<char>('0' + colorIndex - 8));
+    } else if (colorIndex >= 0) {
+        out += ";3";
+        out.push_back(static_cast<char>('0' + colorIndex));
+    }
+    out.push_back('m');
+}
+
+void append_palette(std::string& out, int index, std::uint32_t rgb) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    out += "\033]4;" + std::to_string(index) + ";rgb:";
+    for (int shift = 16; shift >= 0; shift -= 8) {
+        unsigned channel = (rgb >> shift) & 0xff;
+        out += kHex[channel >> 4];
+        out += kHex[channel & 0xf];
+        if (shift > 0) {
+            out += '/';
+        }
+    }
+    out += "\033\\";
+}
+
+void compose_tree(AnsiCanvas& canvas, const std::vector<TreePart>& parts, const BonsaiConfig& config) {
+    int rows = canvas.rows();
+    int cols = canvas.cols();
+
+    auto [baseHeight, baseWidth] = base_dimensions(config.baseType);
+    if (baseHeight > 0 && baseWidth > 0) {
+        auto [startY, startX] = base_origin(config, rows, cols);
+        for (const auto& segment : base_segments(config)) {
+            canvas.putText(startY + segment.row, startX + segment.col, segment.text,
+                           segment.colorIndex, segment.bold);
+        }
+    }
+
+    int treeHeight = rows - baseHeight;
+    for (const auto& part : parts) {
+        if (part.y < 0 || part.y >= treeHeight || part.x < 0 || part.x >= cols) {
+            continue;
+        }
+        canvas.put(part);
+    }
+
+    compose_message(canvas, config);
+}
+
+void compose_parts(AnsiCanvas& canvas, const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                   const BonsaiConfig& config) {
+    if (indices.empty()) {
+        return;
+    }
+
+    int treeHeight = canvas.rows() - base_dimensions(config.baseType).first;
+    for (std::size_t index : indices) {
+        if (index >= parts.size()) {
+            continue;
+        }
+        const TreePart& part = parts[index];
+        if (part.y < 0 || part.y >= treeHeight || part.x < 0 || part.x >= canvas.cols()) {
+            continue;
+        }
+        canvas.put(part);
+    }
+
+    compose_message(canvas, config);
+}
+
+void compose_cells(AnsiCanvas& canvas, const std::vector<TreePart>& cells, const BonsaiConfig& config) {
+    if (cells.empty()) {
+        return;
+    }
+
+    int treeHeight = canvas.rows() - base_dimensions(config.baseType).first;
+    for (const TreePart& cell : cells) {
+        if (cell.y < 0 || cell.y >= treeHeight || cell.x < 0 || cell.x >= canvas.cols()) {
+            continue;
+        }
+        canvas.put(cell);
+    }
+
+    compose_message(canvas, config);
+}
+
+void compose_title(AnsiCanvas& canvas, const TitleConfig& config) {
+    if (config.text.empty()) {
+        return;
+    }
+
+    auto [y, x] = title_position(config.text, canvas.rows(), canvas.cols());
+    canvas.putText(y, x, utf8_to_wstring(config.text), kTextColor, true);
+}
+
+std::string render_ansi(const std::vector<TreePart>& parts, const BonsaiConfig& config, int rows, int cols) {
+    AnsiCanvas canvas(rows, cols);
+    compose_tree(canvas, parts, config);
+
+    std::string out;
+    canvas.encode(out);
+    return out;
+}
+
+} // namespace hbonsai
@@ -1,255 +1,163 @@
 #include "hbonsai/bonsai.h"
 
 #include <algorithm>
-#include <cwchar>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <limits>
 #include <string>
+#include <string_view>
+
+#include "hbonsai/mersenne.h"
+#include "hbonsai/philox.h"
+#include "hbonsai/thread_pool.h"
+#include "hbonsai/utf8.h"
 
 namespace hbonsai {
 namespace {
 
-std::wstring utf8_to_wstring(const std::string& input) {
-    std::wstring output;
-    output.reserve(input.size());
-
-    size_t i = 0;
-    while (i < input.size()) {
-        unsigned char byte = static_cast<unsigned char>(input[i]);
-        char32_t codepoint = 0;
-        size_t continuation_count = 0;
-
-        if ((byte & 0x80u) == 0) {
-            codepoint = byte;
-        } else if ((byte & 0xE0u) == 0xC0u) {
-            codepoint = byte & 0x1Fu;
-            continuation_count = 1;
-        } else if ((byte & 0xF0u) == 0xE0u) {
-            codepoint = byte & 0x0Fu;
-            continuation_count = 2;
-        } else if ((byte & 0xF8u) == 0xF0u) {
-            codepoint = byte & 0x07u;
-            continuation_count = 3;
-        } else {
-            ++i;
-            continue;
-        }
-
-        if (i + continuation_count >= input.size()) {
-            break;
-        }
-
-        bool valid = true;
-        for (size_t j = 1; j <= continuation_count; ++j) {
-            unsigned char follow = static_cast<unsigned char>(input[i + j]);
-            if ((follow & 0xC0u) != 0x80u) {
-                valid = false;
+// Per-branch-type movement tables, indexed directly by the dice roll. They
+// replace the `if (dice <= N)` chains of ref.c's setDeltas; the roll sizes and
+// the order in which rolls are taken are unchanged, so trees are identical.
+constexpr std::array<int, 10> kYoungTrunkDx = {-2, -1, -1, -1, 0, 0, 1, 1, 1, 2};
+constexpr std::array<int, 10> kTrunkDy = {0, 0, 0, -1, -1, -1, -1, -1, -1, -1};
+constexpr std::array<int, 10> kShootDy = {-1, -1, 0, 0, 0, 0, 0, 0, 1, 1};
+constexpr std::array<int, 10> kShootLeftDx = {-2, -2, -1, -1, -1, -1, 0, 0, 0, 1};
+constexpr std::array<int, 10> kShootRightDx = {2, 2, 1, 1, 1, 1, 0, 0, 0, -1};
+constexpr std::array<int, 10> kDyingDy = {-1, -1, 0, 0, 0, 0, 0, 0, 0, 1};
+constexpr std::array<int, 15> kDyingDx = {-3, -2, -2, -1, -1, -1, 0, 0, 0, 1, 1, 1, 2, 2, 3};
+constexpr std::array<int, 10> kDeadDy = {-1, -1, -1, 0, 0, 0, 0, 1, 1, 1};
+
+// One `else if (dice <= last) delta = value;` arm of the original chains.
+struct Band {
+    int last;
+    int delta;
+};
+
+// Replays a threshold chain for every possible roll and compares it with the table.
+template <size_t N, size_t B>
+constexpr bool follows_bands(const std::array<int, N>& table, const std::array<Band, B>& bands) {
+    for (size_t dice = 0; dice < N; ++dice) {
+        int expected = bands[B - 1].delta;
+        for (const Band& band : bands) {
+            if (static_cast<int>(dice) <= band.last) {
+                expected = band.delta;
                 break;
             }
-            codepoint = (codepoint << 6) | (follow & 0x3Fu);
         }
-
-        if (!valid) {
-            ++i;
-            continue;
+        if (table[dice] != expected) {
+            return false;
         }
-
-        output.push_back(static_cast<wchar_t>(codepoint));
-        i += continuation_count + 1;
     }
-
-    return output;
+    return bands[B - 1].last == static_cast<int>(N) - 1;
 }
 
-} // namespace
-
-Bonsai::Bonsai(const BonsaiConfig& config)
-    : config_(config), rng_(config.seed == 0 ? std::random_device{}()
-                                             : static_cast<unsigned int>(config.seed)) {
-    if (config_.leaves.empty()) {
-        leaves_.push_back(L"&");
-    } else {
-        for (const auto& leaf : config_.leaves) {
-            if (!leaf.empty()) {
-                leaves_.push_back(utf8_to_wstring(leaf));
-            }
-        }
-        if (leaves_.empty()) {
-            leaves_.push_back(L"&");
+static_assert(follows_bands(kYoungTrunkDx, std::array<Band, 5>{{{0, -2}, {3, -1}, {5, 0}, {8, 1}, {9, 2}}}));
+static_assert(follows_bands(kTrunkDy, std::array<Band, 2>{{{2, 0}, {9, -1}}}));
+static_assert(follows_bands(kShootDy, std::array<Band, 3>{{{1, -1}, {7, 0}, {9, 1}}}));
+static_assert(follows_bands(kShootLeftDx, std::array<Band, 4>{{{1, -2}, {5, -1}, {8, 0}, {9, 1}}}));
+static_assert(follows_bands(kShootRightDx, std::array<Band, 4>{{{1, 2}, {5, 1}, {8, 0}, {9, -1}}}));
+static_assert(follows_bands(kDyingDy, std::array<Band, 3>{{{1, -1}, {8, 0}, {9, 1}}}));
+static_assert(follows_bands(kDyingDx,
+                            std::array<Band, 7>{{{0, -3}, {2, -2}, {5, -1}, {8, 0}, {11, 1}, {13, 2}, {14, 3}}}));
+static_assert(follows_bands(kDeadDy, std::array<Band, 3>{{{2, -1}, {6, 0}, {9, 1}}}));
+
+void emit_string(int y, int x, std::wstring_view str, int colorIndex, bool bold, int treeWidth,
+                 std::uint32_t step, std::vector<TreePart>& parts) {
+    // Wood glyphs are plain ASCII, one column per character. Callers clamp y
+    // into the tree already.
+    int currentX = x;
+    for (wchar_t wc : str) {
+        if (currentX >= 0 && currentX < treeWidth) {
+            TreePart part;
+            part.x = currentX;
+            part.y = y;
+            part.ch = wc;
+            part.colorIndex = colorIndex;
+            part.bold = bold;
+            part.step = step;
+            parts.push_back(part);
         }
+        ++currentX;
     }
 }
 
-std::vector<TreePart> Bonsai::generate(int height, int width) {
-    std::vector<TreePart> parts;
-    if (height <= 0 || width <= 0) {
-        return parts;
+void emit_leaf(int y, int x, const Leaf& leaf, int colorIndex, bool bold, int treeWidth,
+               std::uint32_t step, std::vector<TreePart>& parts) {
+    int currentX = x;
+    for (const Grapheme& cluster : leaf) {
+        if (currentX >= 0 && currentX < treeWidth) {
+            TreePart part;
+            part.x = currentX;
+            part.y = y;
+            part.ch = cluster.first;
+            part.colorIndex = colorIndex;
+            part.bold = bold;
+            part.leaf = true;
+            part.width = static_cast<std::uint8_t>(cluster.width);
+            part.egc = cluster.utf8.c_str();
+            part.step = step;
+            parts.push_back(part);
+        }
+        currentX += cluster.width;
     }
+}
 
-    treeHeight_ = height;
-    treeWidth_ = width;
-
-    Counters counters;
-    counters.shootCounter = roll(1000);
-
-    int startY = treeHeight_ - 1;
-    int startX = treeWidth_ / 2;
-
-    branch(startY, startX, config_.lifeStart, BranchType::Trunk, counters, parts);
-
-    return parts;
+// Rolls a die with one face per table entry and returns that entry.
+template <class Ctx, size_t N>
+int roll_from(Ctx& ctx, const std::array<int, N>& table) {
+    return table[static_cast<size_t>(ctx.roll(static_cast<int>(N)))];
 }
 
-int Bonsai::roll(int max) {
-    if (max <= 0) {
-        return 0;
-    }
-    std::uniform_int_distribution<int> dist(0, max - 1);
-    return dist(rng_);
+constexpr bool is_leaf_type(BranchType type) {
+    return type == BranchType::Dying || type == BranchType::Dead;
 }
 
-std::pair<int, int> Bonsai::setDeltas(BranchType type, int life, int age, int multiplier) {
-    int dx = 0;
-    int dy = 0;
-    int dice = 0;
-    int safeMultiplier = std::max(1, multiplier);
+// The growth rules below are shared by every engine. They are templates on
+// BranchType so the per-step dispatch is resolved at compile time, and on a
+// context that supplies randomness (roll), output (emitString and emitLeaf),
+// the branch counters, recursion (branch<Type>) and early exit (abandoned).
 
-    switch (type) {
-    case BranchType::Trunk: {
+template <BranchType Type, class Ctx>
+std::pair<int, int> set_deltas(Ctx& ctx, int life, int age, int multiplier) {
+    if constexpr (Type == BranchType::Trunk) {
         if (age <= 2 || life < 4) {
-            dy = 0;
-            dx = roll(3) - 1;
-        } else if (age < safeMultiplier * 3) {
-            int step = std::max(1, static_cast<int>(safeMultiplier * 0.5f));
-            if (step > 0 && age % step == 0) {
-                dy = -1;
-            } else {
-                dy = 0;
-            }
-
-            dice = roll(10);
-            if (dice == 0) {
-                dx = -2;
-            } else if (dice >= 1 && dice <= 3) {
-                dx = -1;
-            } else if (dice >= 4 && dice <= 5) {
-                dx = 0;
-            } else if (dice >= 6 && dice <= 8) {
-                dx = 1;
-            } else {
-                dx = 2;
-            }
-        } else {
-            dice = roll(10);
-            dy = (dice > 2) ? -1 : 0;
-            dx = roll(3) - 1;
-        }
-        break;
-    }
-    case BranchType::ShootLeft: {
-        dice = roll(10);
-        if (dice <= 1) {
-            dy = -1;
-        } else if (dice <= 7) {
-            dy = 0;
-        } else {
-            dy = 1;
-        }
-
-        dice = roll(10);
-        if (dice <= 1) {
-            dx = -2;
-        } else if (dice <= 5) {
-            dx = -1;
-        } else if (dice <= 8) {
-            dx = 0;
-        } else {
-            dx = 1;
-        }
-        break;
-    }
-    case BranchType::ShootRight: {
-        dice = roll(10);
-        if (dice <= 1) {
-            dy = -1;
-        } else if (dice <= 7) {
-            dy = 0;
-        } else {
-            dy = 1;
-        }
-
-        dice = roll(10);
-        if (dice <= 1) {
-            dx = 2;
-        } else if (dice <= 5) {
-            dx = 1;
-        } else if (dice <= 8) {
-            dx = 0;
-        } else {
-            dx = -1;
-        }
-        break;
-    }
-    case BranchType::Dying: {
-        dice = roll(10);
-        if (dice <= 1) {
-            dy = -1;
-        } else if (dice <= 8) {
-            dy = 0;
-        } else {
-            dy = 1;
-        }
-
-        dice = roll(15);
-        if (dice == 0) {
-            dx = -3;
-        } else if (dice <= 2) {
-            dx = -2;
-        } else if (dice <= 5) {
-            dx = -1;
-        } else if (dice <= 8) {
-            dx = 0;
-        } else if (dice <= 11) {
-            dx = 1;
-        } else if (dice <= 13) {
-            dx = 2;
-        } else {
-            dx = 3;
+            return {ctx.roll(3) - 1, 0};
         }
-        break;
-    }
-    case BranchType::Dead: {
-        dice = roll(10);
-        if (dice <= 2) {
-            dy = -1;
-        } else if (dice <= 6) {
-            dy = 0;
-        } else {
-            dy = 1;
+        if (age < multiplier * 3) {
+            int step = std::max(1, static_cast<int>(multiplier * 0.5f));
+            int dy = (age % step == 0) ? -1 : 0;
+            return {roll_from(ctx, kYoungTrunkDx), dy};
         }
-        dx = roll(3) - 1;
-        break;
-    }
+        int dy = roll_from(ctx, kTrunkDy);
+        return {ctx.roll(3) - 1, dy};
+    } else if constexpr (Type == BranchType::ShootLeft) {
+        int dy = roll_from(ctx, kShootDy);
+        return {roll_from(ctx, kShootLeftDx), dy};
+    } else if constexpr (Type == BranchType::ShootRight) {
+        int dy = roll_from(ctx, kShootDy);
+        return {roll_from(ctx, kShootRightDx), dy};
+    } else if constexpr (Type == BranchType::Dying) {
+        int dy = roll_from(ctx, kDyingDy);
+        return {roll_from(ctx, kDyingDx), dy};
+    } else {
+        int dy = roll_from(ctx, kDeadDy);
+        return {ctx.roll(3) - 1, dy};
     }
-
-    return {dx, dy};
 }
 
-std::wstring Bonsai::chooseString(BranchType type, int life, int dx, int dy) {
-    if (life < 4) {
-        type = BranchType::Dying;
-    }
-
-    switch (type) {
-    case BranchType::Trunk:
+template <BranchType Type>
+std::wstring_view choose_string(int dx, int dy) {
+    if constexpr (Type == BranchType::Trunk) {
         if (dy == 0) {
             return L"/~";
         } else if (dx < 0) {
             return L"\\|";
         } else if (dx == 0) {
             return L"/|\\";
-        } else {
-            return L"|/";
         }
-    case BranchType::ShootLeft:
+        return L"|/";
+    } else if constexpr (Type == BranchType::ShootLeft) {
         if (dy > 0) {
             return L"\\";
         } else if (dy == 0) {
@@ -260,7 +168,7 @@ std::wstring Bonsai::chooseString(BranchType type, int life, int dx, int dy) {
             return L"/|";
         }
         return L"/";
-    case BranchType::ShootRight:
+    } else if constexpr (Type == BranchType::ShootRight) {
         if (dy > 0) {
             return L"/";
         } else if (dy == 0) {
@@ -271,103 +179,90 @@ std::wstring Bonsai::chooseString(BranchType type, int life, int dx, int dy) {
             return L"/|";
         }
         return L"/";
-    case BranchType::Dying:
-    case BranchType::Dead: {
-        const auto& leaf = leaves_[roll(static_cast<int>(leaves_.size()))];
-        return leaf;
-    }
+    } else {
+        return L"?"; // leaves are chosen with choose_leaf
     }
-    return L"?";
 }
 
-int Bonsai::chooseColor(BranchType type, bool& bold) {
-    bold = false;
-    switch (type) {
-    case BranchType::Trunk:
-    case BranchType::ShootLeft:
-    case BranchType::ShootRight:
-        if (roll(2) == 0) {
-            bold = true;
-            return config_.colors[3];
-        }
-        return config_.colors[1];
-    case BranchType::Dying:
-        if (roll(10) == 0) {
-            bold = true;
-        }
-        return config_.colors[2];
-    case BranchType::Dead:
-        if (roll(3) == 0) {
-            bold = true;
-        }
-        return config_.colors[0];
-    }
-    return config_.colors[1];
+template <class Ctx>
+const Leaf& choose_leaf(Ctx& ctx) {
+    const auto& leaves = ctx.leaves();
+    return leaves[static_cast<size_t>(ctx.roll(static_cast<int>(leaves.size())))];
 }
 
-void Bonsai::emitString(int y, int x, const std::wstring& str, int colorIndex, bool bold,
-                       std::vector<TreePart>& parts) {
-    int currentX = x;
-    for (wchar_t wc : str) {
-        int width = wcwidth(wc);
-        if (width <= 0) {
-            width = 1;
-        }
-
-        if (currentX >= 0 && currentX < treeWidth_ && y >= 0 && y < treeHeight_) {
-            TreePart part;
-            part.x = currentX;
-            part.y = y;
-            part.ch = wc;
-            part.colorIndex = colorIndex;
-            part.bold = bold;
-            parts.push_back(part);
+template <BranchType Type, class Ctx>
+int choose_color(Ctx& ctx, bool& bold) {
+    const auto& colors = ctx.config().colors;
+    if constexpr (Type == BranchType::Dying) {
+        bold = ctx.roll(10) == 0;
+        return colors[2];
+    } else if constexpr (Type == BranchType::Dead) {
+        bold = ctx.roll(3) == 0;
+        return colors[0];
+    } else {
+        if (ctx.roll(2) == 0) {
+            bold = true;
+            return colors[3];
         }
-
-        currentX += width;
+        bold = false;
+        return colors[1];
     }
 }
 
-void Bonsai::branch(int y, int x, int life, BranchType type, Counters& counters,
-                    std::vector<TreePart>& parts) {
+// Recursive branch growth translated from ref.c
+template <BranchType Type, class Ctx>
+void grow(Ctx& ctx, int y, int x, int life) {
     if (life <= 0) {
         return;
     }
 
+    const BonsaiConfig& config = ctx.config();
+    const int treeHeight = ctx.height();
+    const int treeWidth = ctx.width();
+    Bonsai::Counters& counters = ctx.counters();
+
     counters.branches++;
-    int safeMultiplier = std::max(1, config_.multiplier);
+    int safeMultiplier = std::max(1, config.multiplier);
     int shootCooldown = safeMultiplier;
 
     while (life > 0) {
+        if (ctx.abandoned()) {
+            return;
+        }
         life--;
-        int age = config_.lifeStart - life;
-        auto [dx, dy] = setDeltas(type, life, age, safeMultiplier);
+        counters.steps++;
+        int age = config.lifeStart - life;
+        auto [dx, dy] = set_deltas<Type>(ctx, life, age, safeMultiplier);
 
-        if (dy > 0 && y > (treeHeight_ - 2)) {
+        if (dy > 0 && y > (treeHeight - 2)) {
             dy--;
         }
 
+        // Near-dead branches always burst into leaves; dying trunks and shoots
+        // turn into leaves too, and only trunks ever re-branch.
         if (life < 3) {
-            branch(y, x, life, BranchType::Dead, counters, parts);
-        } else if (type == BranchType::Trunk && life < (safeMultiplier + 2)) {
-            branch(y, x, life, BranchType::Dying, counters, parts);
-        } else if ((type == BranchType::ShootLeft || type == BranchType::ShootRight) &&
-                   life < (safeMultiplier + 2)) {
-            branch(y, x, life, BranchType::Dying, counters, parts);
-        } else if (type == BranchType::Trunk &&
-                   ((roll(3) == 0) || (safeMultiplier > 0 && life > 0 && life % safeMultiplier == 0))) {
-            if (roll(8) == 0 && life > 7) {
-                shootCooldown = safeMultiplier * 2;
-                int extraLife = roll(5) - 2;
-                branch(y, x, life + extraLife, BranchType::Trunk, counters, parts);
-            } else if (shootCooldown <= 0) {
-                shootCooldown = safeMultiplier * 2;
-                int shootLife = life + safeMultiplier;
-                counters.shoots++;
-                counters.shootCounter++;
-                BranchType branchType = (counters.shootCounter % 2 == 0) ? BranchType::ShootRight
-                                                                        : BranchType::ShootLeft;
-                branch(y, x, shootLife, branchType, counters, parts);
+            ctx.template branch<BranchType::Dead>(y, x, life);
+        } else if constexpr (!is_leaf_type(Type)) {
+            if (life < (safeMultiplier + 2)) {
+                ctx.template branch<BranchType::Dying>(y, x, life);
+            } else if constexpr (Type == BranchType::Trunk) {
+                if ((ctx.roll(3) == 0) || (life % safeMultiplier == 0)) {
+                    if (ctx.roll(8) == 0 && life > 7) {
+                        shootCooldown = safeMultiplier * 2;
+                        int extraLife = ctx.roll(5) - 2;
+                        ctx.template branch<BranchType::Trunk>(y, x, life + extraLife);
+                    } else if (shootCooldown <= 0) {
+                        shootCooldown = safeMultiplier * 2;
+                        int shootLife = life + safeMultiplier;
+                        counters.shoots++;
+                        counters.shootCounter++;
+                        if (counters.shootCounter % 2 == 0) {
+                            ctx.template branch<BranchType::ShootRight>(y, x, shootLife);
+                        } else {
+                            ctx.template branch<BranchType::ShootLeft>(y, x, shootLife);
+                        }
+                    }
+                }
             }
         }
 
@@ -376,18 +271,526 @@ void Bonsai::branch(int y, int x, int life, BranchType type, Counters& counters,
         x += dx;
         y += dy;
 
-        if (treeWidth_ > 0) {
-            x = std::clamp(x, 0, treeWidth_ - 1);
+        x = std::clamp(x, 0, treeWidth - 1);
+        y = std::clamp(y, 0, treeHeight - 1);
+
+        bool bold = false;
+        int color = choose_color<Type>(ctx, bold);
+        if (is_leaf_type(Type) || life < 4) {
+            ctx.emitLeaf(y, x, choose_leaf(ctx), color, bold);
+        } else {
+            ctx.emitString(y, x, choose_string<Type>(dx, dy), color, bold);
+        }
+    }
+}
+
+template <class Engine>
+int roll_uniform(Engine& rng, int max) {
+    if (max <= 0) {
+        return 0;
+    }
+    std::uniform_int_distribution<int> dist(0, max - 1);
+    return dist(rng);
+}
+
+// BonsaiConfig's generation budgets, resolved for one tree. Every engine
+// checks them once per growth step, so a check is a few compares; the clock
+// is only read every kClockSteps steps.
+class Budget {
+public:
+    static constexpr long long kClockSteps = 1024;
+
+    Budget(const BonsaiConfig& config, bool timed) {
+        if (config.maxParts > 0) {
+            parts_ = static_cast<std::size_t>(config.maxParts);
+        }
+        if (config.maxMemoryKb > 0) {
+            memoryParts_ = std::max<std::size_t>(
+                1, static_cast<std::size_t>(config.maxMemoryKb) * 1024 / sizeof(TreePart));
+        }
+        if (config.maxBranches > 0) {
+            branches_ = config.maxBranches;
         }
-        if (treeHeight_ > 0) {
-            y = std::clamp(y, 0, treeHeight_ - 1);
+        timed_ = timed && config.maxSeconds > 0.0;
+        if (timed_) {
+            deadline_ = std::chrono::steady_clock::now() +
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(config.maxSeconds));
         }
+    }
 
-        bool bold = false;
-        int color = chooseColor(type, bold);
-        std::wstring glyph = chooseString(type, life, dx, dy);
-        emitString(y, x, glyph, color, bold, parts);
+    // Which budget a tree of this size has reached, if any. The clock is read
+    // only when readClock is set.
+    Truncation check(std::size_t parts, long long branches, bool readClock) const {
+        if (parts >= memoryParts_) {
+            return Truncation::Memory;
+        }
+        if (parts >= parts_) {
+            return Truncation::Parts;
+        }
+        if (branches > branches_) {
+            return Truncation::Branches;
+        }
+        if (readClock && timed_ && std::chrono::steady_clock::now() >= deadline_) {
+            return Truncation::Time;
+        }
+        return Truncation::None;
+    }
+
+    // Makes room for `glyphs` more parts without letting the vector's usual
+    // doubling overshoot the memory budget.
+    void reserve(std::vector<TreePart>& parts, std::size_t glyphs) const {
+        std::size_t need = parts.size() + glyphs;
+        if (need > parts.capacity()) {
+            parts.reserve(std::max(need, std::min(parts.capacity() * 2, memoryParts_)));
+        }
+    }
+
+private:
+    std::size_t parts_ = std::numeric_limits<std::size_t>::max();
+    std::size_t memoryParts_ = std::numeric_limits<std::size_t>::max();
+    long long branches_ = std::numeric_limits<long long>::max();
+    bool timed_ = false;
+    std::chrono::steady_clock::time_point deadline_;
+};
+
+// Serial engine: a single mt19937 and a single set of counters for the whole
+// tree, in the exact order of ref.c. This is what seeds are promised to mean.
+class SerialGrowth {
+public:
+    SerialGrowth(std::mt19937& rng, const BonsaiConfig& config, const std::vector<Leaf>& leaves,
+                 int height, int width, Bonsai::Counters& counters, std::vector<TreePart>& parts)
+        : rng_(rng), config_(config), leaves_(leaves), height_(height), width_(width),
+          counters_(counters), parts_(parts), budget_(config, true) {}
+
+    int roll(int max) { return roll_uniform(rng_, max); }
+
+    template <BranchType Type>
+    void branch(int y, int x, int life) {
+        grow<Type>(*this, y, x, life);
+    }
+
+    bool abandoned() {
+        if (truncation_ == Truncation::None) {
+            bool readClock = counters_.steps % Budget::kClockSteps == 0;
+            truncation_ = budget_.check(parts_.size(), counters_.branches, readClock);
+        }
+        return truncation_ != Truncation::None;
+    }
+
+    void emitString(int y, int x, std::wstring_view str, int colorIndex, bool bold) {
+        budget_.reserve(parts_, str.size());
+        emit_string(y, x, str, colorIndex, bold, width_, step_++, parts_);
+    }
+    void emitLeaf(int y, int x, const Leaf& leaf, int colorIndex, bool bold) {
+        budget_.reserve(parts_, leaf.size());
+        emit_leaf(y, x, leaf, colorIndex, bold, width_, step_++, parts_);
+    }
+
+    Truncation truncation() const { return truncation_; }
+
+    const BonsaiConfig& config() const { return config_; }
+    const std::vector<Leaf>& leaves() const { return leaves_; }
+    int height() const { return height_; }
+    int width() const { return width_; }
+    Bonsai::Counters& counters() { return counters_; }
+
+private:
+    std::mt19937& rng_;
+    const BonsaiConfig& config_;
+    const std::vector<Leaf>& leaves_;
+    int height_;
+    int width_;
+    Bonsai::Counters& counters_;
+    std::vector<TreePart>& parts_;
+    std::uint32_t step_ = 0;
+    Budget budget_;
+    Truncation truncation_ = Truncation::None;
+};
+
+// Survey engine: the serial engine's control flow and dice, but each glyph
+// only widens a bounding box and bumps a counter. Counts exactly the parts
+// SerialGrowth would store. Draws from BlockMt19937, which is std::mt19937
+// without the per-draw overhead.
+class SerialCount {
+public:
+    SerialCount(BlockMt19937& rng, const BonsaiConfig& config, const std::vector<Leaf>& leaves, int height,
+                int width, const Bonsai::SurveyLimits& limits, Bonsai::Summary& summary)
+        : rng_(rng), config_(config), leaves_(leaves), height_(height), width_(width), limits_(limits),
+          summary_(summary), budget_(config, false) {}
+
+    int roll(int max) { return roll_uniform(rng_, max); }
+
+    // Checked once per growth step, so a hopeless tree costs at most one
+    // step per open branch more than it had to. Budgets stop the tree where
+    // generate() would; limits abandon it.
+    bool abandoned() {
+        if (summary_.abandoned || summary_.truncation != Truncation::None) {
+            return true;
+        }
+        std::size_t parts = static_cast<std::size_t>(summary_.parts);
+        summary_.truncation = budget_.check(parts, summary_.counters.branches, false);
+        return checkLimits() || summary_.truncation != Truncation::None;
+    }
+
+    bool checkLimits() {
+        const Bonsai::Summary& s = summary_;
+        bool over = s.parts > limits_.parts || s.leaves > limits_.leaves || s.edge > limits_.edge ||
+                    s.counters.branches > limits_.branches || s.counters.shoots > limits_.shoots ||
+                    (s.minX <= s.maxX && (s.maxX - s.minX >= limits_.width || s.maxY - s.minY >= limits_.height));
+        if (over || (limits_.cutoff && limits_.cutoff->load(std::memory_order_relaxed) < limits_.ordinal)) {
+            summary_.abandoned = true;
+        }
+        return summary_.abandoned;
+    }
+
+    template <BranchType Type>
+    void branch(int y, int x, int life) {
+        grow<Type>(*this, y, x, life);
+    }
+
+    void emitString(int y, int x, std::wstring_view str, int colorIndex, bool bold) {
+        (void)colorIndex;
+        (void)bold;
+        // The same columns emit_string keeps, without the loop.
+        int first = std::max(x, 0);
+        int last = std::min(x + static_cast<int>(str.size()), width_) - 1;
+        if (first > last) {
+            return;
+        }
+        cover(y, first, last, last - first + 1);
+        if (y == 0) {
+            summary_.edge += last - first + 1;
+        } else {
+            summary_.edge += (first == 0 || first == width_ - 1) + (last != first && last == width_ - 1);
+        }
+    }
+    void emitLeaf(int y, int x, const Leaf& leaf, int colorIndex, bool bold) {
+        (void)colorIndex;
+        (void)bold;
+        int currentX = x;
+        for (const Grapheme& cluster : leaf) {
+            if (currentX >= 0 && currentX < width_) {
+                int right = currentX + cluster.width - 1;
+                cover(y, currentX, right, 1);
+                ++summary_.leaves;
+                summary_.edge += y == 0 || currentX == 0 || right >= width_ - 1;
+            }
+            currentX += cluster.width;
+        }
+    }
+
+    const BonsaiConfig& config() const { return config_; }
+    const std::vector<Leaf>& leaves() const { return leaves_; }
+    int height() const { return height_; }
+    int width() const { return width_; }
+    Bonsai::Counters& counters() { return summary_.counters; }
+
+private:
+    void cover(int y, int left, int right, int parts) {
+        summary_.parts += parts;
+        summary_.minY = std::min(summary_.minY, y);
+        summary_.maxY = std::max(summary_.maxY, y);
+        summary_.minX = std::min(summary_.minX, left);
+        summary_.maxX = std::max(summary_.maxX, right);
+    }
+
+    BlockMt19937& rng_;
+    const BonsaiConfig& config_;
+    const std::vector<Leaf>& leaves_;
+    int height_;
+    int width_;
+    const Bonsai::SurveyLimits& limits_;
+    Bonsai::Summary& summary_;
+    Budget budget_;
+};
+
+// Branches with at least this much life are grown as separate pool tasks;
+// shorter ones are grown inline by whoever created them. Either way each
+// branch has its own stream, so the threshold never changes the tree.
+constexpr int kParallelSpawnLife = 12;
+
+// Output of one pool task. Child subtrees are spliced into `parts` at the
+// recorded offsets, which restores the serial depth-first order.
+struct Subtree {
+    std::vector<TreePart> parts;
+    std::vector<std::pair<size_t, std::unique_ptr<Subtree>>> children;
+    Bonsai::Counters counters;
+    std::uint32_t steps = 0; // local step numbers; flatten() renumbers them
+};
+
+// Branches report their parts and branches to ParallelShared in batches of
+// about this many growth steps, so the budget counters stay off the hot path.
+constexpr int kParallelBudgetSteps = 64;
+
+struct ParallelShared {
+    const BonsaiConfig& config;
+    const std::vector<Leaf>& leaves;
+    int height;
+    int width;
+    std::uint64_t key;
+    WorkStealingPool& pool;
+    const Budget& budget;
+    // Budget use of the whole tree, and the first budget it ran into.
+    std::atomic<std::size_t> parts{0};
+    std::atomic<long long> branches{0};
+    std::atomic<Truncation> truncation{Truncation::None};
+};
+
+// Parallel engine context for one branch. Each branch owns its RNG stream and
+// shoot counter; the only shared state is ParallelShared, which is read-only
+// apart from the budget counters.
+class ParallelGrowth {
+public:
+    ParallelGrowth(ParallelShared& shared, Subtree& out, std::uint64_t stream)
+        : shared_(shared), out_(out), rng_(shared.key, stream), stream_(stream) {
+        counters_.shootCounter = rng_.roll(1000);
+    }
+
+    int roll(int max) { return rng_.roll(max); }
+
+    template <BranchType Type>
+    void branch(int y, int x, int life) {
+        std::uint64_t child = child_stream(stream_, ordinal_++);
+        if (life < kParallelSpawnLife) {
+            ParallelGrowth growth(shared_, out_, child);
+            grow<Type>(growth, y, x, life);
+            growth.finish();
+            return;
+        }
+
+        auto subtree = std::make_unique<Subtree>();
+        Subtree* target = subtree.get();
+        out_.children.emplace_back(out_.parts.size(), std::move(subtree));
+        ParallelShared* shared = &shared_;
+        shared_.pool.submit([shared, target, child, y, x, life] {
+            ParallelGrowth growth(*shared, *target, child);
+            grow<Type>(growth, y, x, life);
+            growth.finish();
+        });
+    }
+
+    // Folds this branch's counters into its subtree once it stops growing.
+    void finish() {
+        out_.counters.branches += counters_.branches;
+        out_.counters.shoots += counters_.shoots;
+        out_.counters.steps += counters_.steps;
+        report();
+    }
+
+    // Which branches a budget stops depends on scheduling, so a truncated
+    // parallel tree is not reproducible.
+    bool abandoned() {
+        if (++unreported_ >= kParallelBudgetSteps) {
+            report();
+        }
+        return shared_.truncation.load(std::memory_order_relaxed) != Truncation::None;
+    }
+
+    void emitString(int y, int x, std::wstring_view str, int colorIndex, bool bold) {
+        std::size_t before = out_.parts.size();
+        emit_string(y, x, str, colorIndex, bold, shared_.width, out_.steps++, out_.parts);
+        newParts_ += out_.parts.size() - before;
+    }
+    void emitLeaf(int y, int x, const Leaf& leaf, int colorIndex, bool bold) {
+        std::size_t before = out_.parts.size();
+        emit_leaf(y, x, leaf, colorIndex, bold, shared_.width, out_.steps++, out_.parts);
+        newParts_ += out_.parts.size() - before;
+    }
+
+    const BonsaiConfig& config() const { return shared_.config; }
+    const std::vector<Leaf>& leaves() const { return shared_.leaves; }
+    int height() const { return shared_.height; }
+    int width() const { return shared_.width; }
+    Bonsai::Counters& counters() { return counters_; }
+
+private:
+    void report() {
+        std::size_t parts = shared_.parts.fetch_add(newParts_, std::memory_order_relaxed) + newParts_;
+        long long newBranches = counters_.branches - reportedBranches_;
+        long long branches = shared_.branches.fetch_add(newBranches, std::memory_order_relaxed) + newBranches;
+        newParts_ = 0;
+        reportedBranches_ = counters_.branches;
+        unreported_ = 0;
+
+        Truncation reason = shared_.budget.check(parts, branches, true);
+        Truncation none = Truncation::None;
+        if (reason != Truncation::None) {
+            shared_.truncation.compare_exchange_strong(none, reason, std::memory_order_relaxed);
+        }
+    }
+
+    ParallelShared& shared_;
+    Subtree& out_;
+    PhiloxStream rng_;
+    std::uint64_t stream_;
+    std::uint64_t ordinal_ = 0;
+    Bonsai::Counters counters_;
+    std::size_t newParts_ = 0;
+    int reportedBranches_ = 0;
+    int unreported_ = 0;
+};
+
+size_t subtree_size(const Subtree& node) {
+    size_t size = node.parts.size();
+    for (const auto& child : node.children) {
+        size += subtree_size(*child.second);
+    }
+    return size;
+}
+
+// Gives the parts appended from `from` on global step numbers. Children are
+// spliced in between two steps of their parent, so a segment always starts a
+// new step.
+void renumber_steps(std::vector<TreePart>& parts, size_t from, std::uint32_t& nextStep) {
+    std::uint32_t local = 0;
+    for (size_t i = from; i < parts.size(); ++i) {
+        if (i == from || parts[i].step != local) {
+            local = parts[i].step;
+            ++nextStep;
+        }
+        parts[i].step = nextStep - 1;
+    }
+}
+
+void flatten(const Subtree& node, std::vector<TreePart>& parts, Bonsai::Counters& counters,
+             std::uint32_t& nextStep) {
+    size_t next = 0;
+    for (const auto& [offset, child] : node.children) {
+        size_t from = parts.size();
+        parts.insert(parts.end(), node.parts.begin() + static_cast<std::ptrdiff_t>(next),
+                     node.parts.begin() + static_cast<std::ptrdiff_t>(offset));
+        renumber_steps(parts, from, nextStep);
+        next = offset;
+        flatten(*child, parts, counters, nextStep);
+    }
+    size_t from = parts.size();
+    parts.insert(parts.end(), node.parts.begin() + static_cast<std::ptrdiff_t>(next), node.parts.end());
+    renumber_steps(parts, from, nextStep);
+
+    counters.branches += node.counters.branches;
+    counters.shoots += node.counters.shoots;
+    counters.steps += node.counters.steps;
+}
+
+} // namespace
+
+const char* truncation_name(Truncation reason) {
+    switch (reason) {
+    case Truncation::Parts:
+        return "parts";
+    case Truncation::Branches:
+        return "branches";
+    case Truncation::Memory:
+        return "memory";
+    case Truncation::Time:
+        return "time";
+    case Truncation::None:
+        break;
+    }
+    return "none";
+}
+
+Bonsai::Bonsai(const BonsaiConfig& config)
+    : config_(config), rng_(config.seed == 0 ? std::random_device{}()
+                                             : static_cast<unsigned int>(config.seed)) {
+    if (config_.leaves.empty()) {
+        leaves_.push_back(split_graphemes("&"));
+    } else {
+        for (const auto& leaf : config_.leaves) {
+            if (!leaf.empty()) {
+                leaves_.push_back(split_graphemes(leaf));
+            }
+        }
+        if (leaves_.empty()) {
+            leaves_.push_back(split_graphemes("&"));
+        }
+    }
+
+    if (config_.seed == 0) {
+        std::random_device device;
+        parallelKey_ = (static_cast<std::uint64_t>(device()) << 32) | device();
+    } else {
+        parallelKey_ = static_cast<std::uint64_t>(config_.seed);
     }
 }
 
+Bonsai::~Bonsai() = default;
+
+std::vector<TreePart> Bonsai::generate(int height, int width) {
+    std::vector<TreePart> parts;
+    truncation_ = Truncation::None;
+    if (height <= 0 || width <= 0) {
+        index_.clear();
+        return parts;
+    }
+
+    treeHeight_ = height;
+    treeWidth_ = width;
+
+    if (config_.parallel) {
+        return generateParallel();
+    }
+
+    counters_ = Counters{};
+    SerialGrowth growth(rng_, config_, leaves_, treeHeight_, treeWidth_, counters_, parts);
+    counters_.shootCounter = growth.roll(1000);
+
+    int startY = treeHeight_ - 1;
+    int startX = treeWidth_ / 2;
+
+    growth.branch<BranchType::Trunk>(startY, startX, config_.lifeStart);
+    truncation_ = growth.truncation();
+
+    index_.build(parts, treeHeight_);
+    return parts;
+}
+
+Bonsai::Summary Bonsai::survey(unsigned int seed, int height, int width) const {
+    return survey(seed, height, width, SurveyLimits{});
+}
+
+Bonsai::Summary Bonsai::survey(unsigned int seed, int height, int width, const SurveyLimits& limits) const {
+    Summary summary;
+    if (height <= 0 || width <= 0) {
+        return summary;
+    }
+
+    BlockMt19937 rng(seed);
+    SerialCount count(rng, config_, leaves_, height, width, limits, summary);
+    summary.counters.shootCounter = count.roll(1000);
+    count.branch<BranchType::Trunk>(height - 1, width / 2, config_.lifeStart);
+    count.checkLimits(); // the last glyph may be the one over a limit
+    return summary;
+}
+
+std::vector<TreePart> Bonsai::generateParallel() {
+    if (!pool_) {
+        pool_ = std::make_unique<WorkStealingPool>(static_cast<unsigned>(std::max(0, config_.threads)));
+    }
+
+    // Successive trees from one Bonsai (infinite mode) use successive trunk
+    // streams, so the n-th tree for a seed is always the same.
+    std::uint64_t trunkStream = child_stream(0, parallelTrees_++);
+
+    Subtree root;
+    Budget budget(config_, true);
+    ParallelShared shared{config_, leaves_, treeHeight_, treeWidth_, parallelKey_, *pool_, budget};
+    {
+        ParallelGrowth growth(shared, root, trunkStream);
+        growth.branch<BranchType::Trunk>(treeHeight_ - 1, treeWidth_ / 2, config_.lifeStart);
+        growth.finish();
+    }
+    pool_->wait();
+    truncation_ = shared.truncation.load();
+
+    counters_ = Counters{};
+    std::vector<TreePart> parts;
+    parts.reserve(subtree_size(root));
+    std::uint32_t steps = 0;
+    flatten(root, parts, counters_, steps);
+    index_.build(parts, treeHeight_);
+    return parts;
+}
+
 } // namespace hbonsai
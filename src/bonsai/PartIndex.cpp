@@ -0,0 +1,94 @@
+#include "hbonsai/part_index.h"
+
+#include "hbonsai/bonsai.h"
+
+namespace hbonsai {
+namespace {
+
+constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+constexpr std::uint32_t kMaxRun = std::numeric_limits<std::uint8_t>::max();
+
+} // namespace
+
+void PartIndex::build(const std::vector<TreePart>& parts, int rows) {
+    rows_ = std::max(0, rows);
+    std::size_t rowCount = static_cast<std::size_t>(rows_);
+
+    // First pass counts the runs of every row, second pass fills them in.
+    std::vector<std::uint32_t> last(rowCount, kNone);
+    std::vector<std::uint32_t> length(rowCount, 0);
+    rowOffsets_.assign(rowCount + 1, 0);
+    for (std::size_t index = 0; index < parts.size(); ++index) {
+        int y = parts[index].y;
+        if (y < 0 || y >= rows_) {
+            continue;
+        }
+        std::uint32_t current = static_cast<std::uint32_t>(index);
+        if (last[y] == kNone || last[y] + 1 != current || length[y] == kMaxRun) {
+            ++rowOffsets_[y + 1];
+            length[y] = 0;
+        }
+        last[y] = current;
+        ++length[y];
+    }
+    for (std::size_t row = 0; row < rowCount; ++row) {
+        rowOffsets_[row + 1] += rowOffsets_[row];
+    }
+
+    std::uint32_t runs = rowOffsets_[rowCount];
+    runStart_.assign(runs, 0);
+    runLength_.assign(runs, 0);
+    runStart_.shrink_to_fit();
+    runLength_.shrink_to_fit();
+
+    std::vector<std::uint32_t>& next = length; // next free run slot per row
+    for (std::size_t row = 0; row < rowCount; ++row) {
+        next[row] = rowOffsets_[row];
+        last[row] = kNone;
+    }
+    for (std::size_t index = 0; index < parts.size(); ++index) {
+        int y = parts[index].y;
+        if (y < 0 || y >= rows_) {
+            continue;
+        }
+        std::uint32_t current = static_cast<std::uint32_t>(index);
+        std::uint32_t run = next[y];
+        if (last[y] == kNone || last[y] + 1 != current || runLength_[run - 1] == kMaxRun) {
+            runStart_[run] = current;
+            runLength_[run] = 1;
+            ++next[y];
+        } else {
+            ++runLength_[run - 1];
+        }
+        last[y] = current;
+    }
+}
+
+void PartIndex::clear() {
+    rows_ = 0;
+    rowOffsets_.assign(1, 0);
+    runStart_.clear();
+    runLength_.clear();
+}
+
+std::size_t PartIndex::memoryUsage() const {
+    return rowOffsets_.capacity() * sizeof(std::uint32_t) + runStart_.capacity() * sizeof(std::uint32_t) +
+           runLength_.capacity() * sizeof(std::uint8_t);
+}
+
+std::size_t PartIndex::topmost(const std::vector<TreePart>& parts, int y, int x) const {
+    if (y < 0 || y >= rows_) {
+        return npos;
+    }
+    // Runs are in growth order, so the last covering part found wins.
+    std::size_t found = npos;
+    forEachInRows(y, y, [&](std::size_t index) {
+        const TreePart& part = parts[index];
+        if (x >= part.x && x < part.x + part.width) {
+            found = index;
+        }
+    });
+    return found;
+}
+
+} // namespace hbonsai
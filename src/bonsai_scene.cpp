@@ -2,12 +2,25 @@
 
 #include <algorithm>
 
+#include "hbonsai/alloc_stats.h"
 #include "hbonsai/renderer.h"
 
 namespace hbonsai {
 
-BonsaiScene::BonsaiScene(const AppConfig& appConfig, const BonsaiConfig& bonsaiConfig, const TitleConfig& titleConfig)
-    : appConfig_(appConfig), bonsaiConfig_(bonsaiConfig), titleConfig_(titleConfig), bonsai_(bonsaiConfig) {}
+BonsaiScene::BonsaiScene(const AppConfig& appConfig, const BonsaiConfig& bonsaiConfig, const TitleConfig& titleConfig,
+                         PaceStats* paceStats, GrowthStats* growthStats)
+    : appConfig_(appConfig),
+      bonsaiConfig_(bonsaiConfig),
+      titleConfig_(titleConfig),
+      bonsai_(bonsaiConfig),
+      timeline_(static_cast<std::size_t>(appConfig.checkpointInterval),
+                static_cast<std::size_t>(appConfig.checkpointMemoryKb) * 1024),
+      wind_(appConfig.windBudget),
+      particles_(appConfig.fallingLeaves),
+      seasons_(appConfig.seasonPeriod,
+               {bonsaiConfig.colors[0], bonsaiConfig.colors[1], bonsaiConfig.colors[2], bonsaiConfig.colors[3]}),
+      paceStats_(paceStats),
+      growthStats_(growthStats) {}
 
 void BonsaiScene::onEnter(Renderer& renderer) {
     auto [rows, cols] = renderer.dimensions();
@@ -18,18 +31,132 @@ void BonsaiScene::onEnter(Renderer& renderer) {
 }
 
 void BonsaiScene::resetState() {
-    parts_ = bonsai_.generate(treeHeight_, treeWidth_);
+    {
+        AllocPhaseScope phase(AllocPhase::Generation);
+        parts_ = bonsai_.generate(treeHeight_, treeWidth_);
+    }
+    if (growthStats_) {
+        ++growthStats_->trees;
+        if (bonsai_.lastTruncation() != Truncation::None) {
+            ++growthStats_->truncated;
+            growthStats_->lastTruncation = bonsai_.lastTruncation();
+            growthStats_->lastTruncatedParts = parts_.size();
+        }
+    }
     pendingParts_.clear();
+    effectCells_.clear();
+    if (appConfig_.live) {
+        timeline_.build(parts_, treeHeight_, treeWidth_);
+    }
+    if (appConfig_.windBudget > 0) {
+        wind_.build(parts_, bonsai_.lastIndex(), treeHeight_, treeWidth_);
+    }
+    if (appConfig_.fallingLeaves > 0) {
+        particles_.build(parts_, bonsai_.lastIndex(), treeHeight_, treeWidth_);
+    }
+    if (appConfig_.seasonPeriod > 0.0) {
+        seasons_.reset(parts_);
+    }
+    if (appConfig_.live && appConfig_.pace) {
+        double target = appConfig_.paceSeconds > 0.0
+                            ? appConfig_.paceSeconds
+                            : static_cast<double>(parts_.size()) * static_cast<double>(appConfig_.timeStep);
+        pacer_.reset(parts_.size(), target);
+    }
     nextIndex_ = 0;
     accumulator_ = 0.0;
     started_ = false;
+    paused_ = false;
     finished_ = parts_.empty();
+    dismissed_ = false;
     framePrepared_ = false;
     staticDrawn_ = false;
     titleElapsed_ = 0.0;
+    waitElapsed_ = 0.0;
     titleVisible_ = !titleConfig_.text.empty();
 }
 
+void BonsaiScene::onInput(const InputEvent& event) {
+    // With effects running after growth, any key ends the scene the way it
+    // would otherwise end the final wait.
+    if (finished_ && effectsEnabled() && !appConfig_.infinite) {
+        dismissed_ = true;
+        return;
+    }
+
+    if (!appConfig_.live || finished_ || parts_.empty()) {
+        return;
+    }
+
+    std::size_t total = parts_.size();
+    std::size_t stride = std::max<std::size_t>(1, total / 20);
+    switch (event.code) {
+    case KeyCode::Left:
+        seekTo(nextIndex_ > stride ? nextIndex_ - stride : 0);
+        break;
+    case KeyCode::Right:
+        seekTo(std::min(total, nextIndex_ + stride));
+        break;
+    case KeyCode::Home:
+        seekTo(0);
+        break;
+    case KeyCode::End:
+        seekTo(total);
+        break;
+    case KeyCode::Character:
+        if (event.ch == U' ') {
+            paused_ = !paused_;
+        } else if (event.ch >= U'0' && event.ch <= U'9') {
+            seekTo(total * static_cast<std::size_t>(event.ch - U'0') / 10);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void BonsaiScene::releaseNext() {
+    std::uint32_t step = parts_[nextIndex_].step;
+    pendingParts_.push_back(nextIndex_++);
+    if (!appConfig_.wholeSteps) {
+        return;
+    }
+    while (nextIndex_ < parts_.size() && parts_[nextIndex_].step == step) {
+        pendingParts_.push_back(nextIndex_++);
+    }
+}
+
+void BonsaiScene::seekTo(std::size_t target) {
+    target = std::min(target, parts_.size());
+    // Never stop halfway through a step when steps are drawn whole.
+    while (appConfig_.wholeSteps && target > 0 && target < parts_.size() &&
+           parts_[target].step == parts_[target - 1].step) {
+        ++target;
+    }
+    started_ = true;
+    accumulator_ = 0.0;
+
+    // Short forward hops just draw the skipped parts on top of the canvas.
+    if (target >= nextIndex_ && target - nextIndex_ <= timeline_.interval()) {
+        while (nextIndex_ < target) {
+            pendingParts_.push_back(nextIndex_++);
+        }
+    } else {
+        // Anything else rebuilds the canvas from the nearest checkpoint.
+        pendingParts_.clear();
+        framePrepared_ = false;
+        timeline_.replay(target, [this](std::size_t index) { pendingParts_.push_back(index); });
+        nextIndex_ = target;
+    }
+
+    if (appConfig_.pace) {
+        pacer_.seek(nextIndex_);
+    }
+    if (nextIndex_ >= parts_.size()) {
+        finished_ = true;
+    }
+}
+
 void BonsaiScene::update(double dt) {
     if (titleVisible_ && titleConfig_.displaySeconds > 0.0) {
         titleElapsed_ += dt;
@@ -38,17 +165,37 @@ void BonsaiScene::update(double dt) {
         }
     }
 
+    seasons_.advance(dt);
+
+    bool treeShown = finished_ && (appConfig_.live ? pendingParts_.empty() : staticDrawn_);
+    if (treeShown && appConfig_.windBudget > 0) {
+        wind_.step(dt, effectCells_);
+    }
+    if (treeShown && appConfig_.fallingLeaves > 0) {
+        particles_.step(dt, effectCells_);
+    }
+
+    // Infinite mode: once a tree is fully on screen, hold it for the wait time
+    // and then grow the next one.
+    if (appConfig_.infinite && treeShown) {
+        waitElapsed_ += dt;
+        if (waitElapsed_ >= appConfig_.waitTime) {
+            resetState();
+        }
+        return;
+    }
+
     if (!appConfig_.live) {
         return;
     }
 
-    if (finished_) {
+    if (finished_ || paused_) {
         return;
     }
 
     if (!started_) {
         if (nextIndex_ < parts_.size()) {
-            pendingParts_.push_back(nextIndex_++);
+            releaseNext();
             started_ = true;
         } else {
             finished_ = true;
@@ -56,6 +203,20 @@ void BonsaiScene::update(double dt) {
         }
     }
 
+    if (appConfig_.pace) {
+        std::size_t due = pacer_.advance(dt, nextIndex_, frameCost_);
+        while (nextIndex_ < due) {
+            releaseNext();
+        }
+        if (nextIndex_ >= parts_.size()) {
+            finished_ = true;
+            if (paceStats_) {
+                *paceStats_ = pacer_.stats();
+            }
+        }
+        return;
+    }
+
     if (appConfig_.timeStep <= 0.0f) {
         while (nextIndex_ < parts_.size()) {
             pendingParts_.push_back(nextIndex_++);
@@ -66,7 +227,7 @@ void BonsaiScene::update(double dt) {
 
     accumulator_ += dt;
     while (accumulator_ >= static_cast<double>(appConfig_.timeStep) && nextIndex_ < parts_.size()) {
-        pendingParts_.push_back(nextIndex_++);
+        releaseNext();
         accumulator_ -= static_cast<double>(appConfig_.timeStep);
     }
 
@@ -77,6 +238,7 @@ void BonsaiScene::update(double dt) {
 
 void BonsaiScene::draw(Renderer& renderer) {
     if (!appConfig_.live) {
+        applySeason(renderer, staticDrawn_);
         if (!staticDrawn_) {
             renderer.drawStatic(parts_, bonsaiConfig_);
             if (titleVisible_) {
@@ -85,26 +247,65 @@ void BonsaiScene::draw(Renderer& renderer) {
             staticDrawn_ = true;
             finished_ = true;
         }
+        drawEffects(renderer);
         return;
     }
 
+    frameCost_ = renderer.frameCost();
     if (!framePrepared_) {
         renderer.prepareFrame(bonsaiConfig_);
         framePrepared_ = true;
     }
 
-    for (std::size_t index : pendingParts_) {
-        if (index < parts_.size()) {
-            renderer.drawLive(parts_[index], bonsaiConfig_);
-        }
-    }
+    applySeason(renderer, finished_ && pendingParts_.empty());
+    renderer.drawLive(parts_, pendingParts_, bonsaiConfig_);
+    drawEffects(renderer);
     if (titleVisible_) {
         renderer.renderTitle(titleConfig_);
     }
     pendingParts_.clear();
 }
 
+bool BonsaiScene::effectsEnabled() const {
+    return appConfig_.windBudget > 0 || appConfig_.fallingLeaves > 0 || appConfig_.seasonPeriod > 0.0;
+}
+
+void BonsaiScene::applySeason(Renderer& renderer, bool treeShown) {
+    if (appConfig_.seasonPeriod <= 0.0) {
+        return;
+    }
+    // Only the fallback recolours parts; then everything already on screen is
+    // redrawn, with the effects' moved and falling leaves on top.
+    std::size_t drawn = appConfig_.live ? nextIndex_ : (staticDrawn_ ? parts_.size() : 0);
+    if (!seasons_.apply(renderer, parts_, drawn, effectCells_)) {
+        return;
+    }
+    if (appConfig_.windBudget > 0) {
+        wind_.recolor(parts_);
+        if (treeShown) {
+            wind_.redraw(effectCells_);
+        }
+    }
+    if (appConfig_.fallingLeaves > 0 && treeShown) {
+        particles_.redraw(effectCells_);
+    }
+}
+
+void BonsaiScene::drawEffects(Renderer& renderer) {
+    if (effectCells_.empty()) {
+        return;
+    }
+    renderer.drawCells(effectCells_, bonsaiConfig_);
+    effectCells_.clear();
+}
+
 bool BonsaiScene::isFinished() const {
+    if (appConfig_.infinite) {
+        return false;
+    }
+    if (effectsEnabled()) {
+        return dismissed_;
+    }
     if (!appConfig_.live) {
         return finished_ && staticDrawn_;
     }
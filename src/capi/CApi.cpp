@@ -0,0 +1,182 @@
+#include "hbonsai/hbonsai.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hbonsai/ansi.h"
+#include "hbonsai/bonsai.h"
+#include "hbonsai/layout.h"
+
+struct hbonsai_generator {
+    explicit hbonsai_generator(const hbonsai::BonsaiConfig& bonsaiConfig) : config(bonsaiConfig), bonsai(config) {}
+
+    hbonsai::BonsaiConfig config; // Bonsai keeps a reference; declared first
+    hbonsai::Bonsai bonsai;
+    std::vector<hbonsai::TreePart> parts;
+    int rows = 0;
+    int cols = 0;
+};
+
+namespace {
+
+std::vector<std::string> split_leaves(const char* list) {
+    std::vector<std::string> leaves;
+    std::stringstream stream(list);
+    std::string leaf;
+    while (std::getline(stream, leaf, ',')) {
+        if (!leaf.empty()) {
+            leaves.push_back(leaf);
+        }
+    }
+    return leaves;
+}
+
+} // namespace
+
+extern "C" {
+
+int hbonsai_api_version(void) {
+    return HBONSAI_API_VERSION;
+}
+
+void hbonsai_options_init(hbonsai_options* options) {
+    if (options == nullptr) {
+        return;
+    }
+    hbonsai::BonsaiConfig defaults;
+    *options = hbonsai_options{};
+    options->struct_size = sizeof(hbonsai_options);
+    options->seed = defaults.seed;
+    options->life = defaults.lifeStart;
+    options->multiplier = defaults.multiplier;
+    options->base = defaults.baseType;
+    std::copy(defaults.colors.begin(), defaults.colors.end(), options->colors);
+    options->threads = defaults.threads;
+    options->max_parts = static_cast<long>(defaults.maxParts);
+    options->max_branches = defaults.maxBranches;
+    options->max_memory_kb = static_cast<long>(defaults.maxMemoryKb);
+    options->max_seconds = defaults.maxSeconds;
+}
+
+hbonsai_generator* hbonsai_create(const hbonsai_options* options) {
+    if (options == nullptr) {
+        return nullptr;
+    }
+    // Fields a caller's older, shorter struct lacks keep their defaults.
+    hbonsai_options resolved;
+    hbonsai_options_init(&resolved);
+    std::memcpy(&resolved, options, std::min(options->struct_size, sizeof(resolved)));
+
+    if (resolved.seed < 0 || resolved.life < 1 || resolved.life > 200 || resolved.multiplier < 1 ||
+        resolved.multiplier > 20 || resolved.base < 0 || resolved.threads < 0 || resolved.max_parts < 0 ||
+        resolved.max_branches < 0 || resolved.max_memory_kb < 0 || !(resolved.max_seconds >= 0.0)) {
+        return nullptr;
+    }
+    for (int color : resolved.colors) {
+        if (color < 0 || color > 255) {
+            return nullptr;
+        }
+    }
+
+    hbonsai::BonsaiConfig config;
+    config.seed = resolved.seed;
+    config.lifeStart = resolved.life;
+    config.multiplier = resolved.multiplier;
+    config.baseType = resolved.base;
+    std::copy(std::begin(resolved.colors), std::end(resolved.colors), config.colors.begin());
+    config.parallel = resolved.parallel != 0;
+    config.threads = resolved.threads;
+    config.maxParts = resolved.max_parts;
+    config.maxBranches = resolved.max_branches;
+    config.maxMemoryKb = resolved.max_memory_kb;
+    config.maxSeconds = resolved.max_seconds;
+    if (resolved.leaves != nullptr) {
+        config.leaves = split_leaves(resolved.leaves);
+        if (config.leaves.empty()) {
+            config.leaves = {"&"};
+        }
+    }
+    if (resolved.message != nullptr) {
+        config.message = resolved.message;
+    }
+    // Nothing may unwind into C callers.
+    try {
+        return new hbonsai_generator(config);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+long hbonsai_generate(hbonsai_generator* generator, int rows, int cols) {
+    if (generator == nullptr || rows <= 0 || cols <= 0) {
+        return -1;
+    }
+    int baseHeight = hbonsai::base_dimensions(generator->config.baseType).first;
+    try {
+        generator->parts = generator->bonsai.generate(std::max(1, rows - baseHeight), cols);
+    } catch (...) {
+        generator->parts.clear();
+        generator->rows = 0;
+        return -1;
+    }
+    generator->rows = rows;
+    generator->cols = cols;
+    return static_cast<long>(generator->parts.size());
+}
+
+const char* hbonsai_truncated(const hbonsai_generator* generator) {
+    if (generator == nullptr || generator->rows == 0) {
+        return nullptr;
+    }
+    hbonsai::Truncation reason = generator->bonsai.lastTruncation();
+    return reason == hbonsai::Truncation::None ? nullptr : hbonsai::truncation_name(reason);
+}
+
+size_t hbonsai_get_parts(const hbonsai_generator* generator, hbonsai_part* parts, size_t capacity) {
+    if (generator == nullptr) {
+        return 0;
+    }
+    size_t count = std::min(capacity, generator->parts.size());
+    for (size_t i = 0; i < count && parts != nullptr; ++i) {
+        const hbonsai::TreePart& part = generator->parts[i];
+        parts[i].x = part.x;
+        parts[i].y = part.y;
+        parts[i].codepoint = static_cast<uint32_t>(part.ch);
+        parts[i].color = part.colorIndex;
+        parts[i].bold = part.bold ? 1 : 0;
+        parts[i].width = part.width;
+        parts[i].step = part.step;
+        parts[i].glyph = part.egc;
+    }
+    return generator->parts.size();
+}
+
+size_t hbonsai_render_ansi(const hbonsai_generator* generator, char* out, size_t size) {
+    if (generator == nullptr) {
+        return 0;
+    }
+    std::string text;
+    try {
+        if (generator->rows > 0) {
+            text = hbonsai::render_ansi(generator->parts, generator->config, generator->rows, generator->cols);
+        }
+    } catch (...) {
+        text.clear();
+    }
+    if (out != nullptr && size > 0) {
+        size_t copied = std::min(size - 1, text.size());
+        std::memcpy(out, text.data(), copied);
+        out[copied] = '\0';
+    }
+    return text.size();
+}
+
+void hbonsai_free(hbonsai_generator* generator) {
+    delete generator;
+}
+
+} // extern "C"
@@ -0,0 +1,29 @@
+#include "hbonsai/clock.h"
+
+#include <chrono>
+#include <poll.h>
+#include <thread>
+
+namespace hbonsai {
+
+double SteadyClock::now() {
+    auto since = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double>(since).count();
+}
+
+void SteadyClock::sleepFor(double seconds, int wakeFd) {
+    if (seconds <= 0.0) {
+        return;
+    }
+    if (wakeFd < 0) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        return;
+    }
+
+    auto nanos = static_cast<long long>(seconds * 1e9);
+    struct timespec timeout {static_cast<time_t>(nanos / 1000000000), static_cast<long>(nanos % 1000000000)};
+    struct pollfd pfd {wakeFd, POLLIN, 0};
+    ppoll(&pfd, 1, &timeout, nullptr);
+}
+
+} // namespace hbonsai
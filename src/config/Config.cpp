@@ -1,4 +1,5 @@
 #include "hbonsai/config.h"
+#include "hbonsai/termcaps.h"
 
 #include <algorithm>
 #include <array>
@@ -8,12 +9,42 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <unistd.h>
 #include <vector>
 
 namespace hbonsai {
 
 namespace {
 
+// Long-only options have no single-character form; keep them out of the ASCII range.
+enum LongOption {
+    kOptDaemon = 256,
+    kOptClient,
+    kOptDaemonWorkers,
+    kOptDaemonPool,
+    kOptParallel,
+    kOptCheckpointInterval,
+    kOptCheckpointMemory,
+    kOptBackend,
+    kOptWind,
+    kOptFallingLeaves,
+    kOptSeasons,
+    kOptWholeSteps,
+    kOptBroadcast,
+    kOptPace,
+    kOptSurvey,
+    kOptSurveySize,
+    kOptSurveyCsv,
+    kOptFindSeed,
+    kOptFindCount,
+    kOptFindLimit,
+    kOptMaxParts,
+    kOptMaxBranches,
+    kOptMaxMemory,
+    kOptMaxTime,
+    kOptAllocStats,
+};
+
 std::vector<std::string> split_list(const std::string& input) {
     std::vector<std::string> result;
     std::stringstream ss(input);
@@ -40,6 +71,28 @@ bool parse_int(const std::string& value, int& out) {
     }
 }
 
+bool parse_long(const std::string& value, long long& out) {
+    try {
+        size_t idx = 0;
+        long long parsed = std::stoll(value, &idx, 10);
+        if (idx != value.size()) {
+            return false;
+        }
+        out = parsed;
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool parse_size(const std::string& value, int& rows, int& cols) {
+    size_t separator = value.find('x');
+    if (separator == std::string::npos) {
+        return false;
+    }
+    return parse_int(value.substr(0, separator), rows) && parse_int(value.substr(separator + 1), cols);
+}
+
 bool parse_float(const std::string& value, float& out) {
     try {
         size_t idx = 0;
@@ -82,6 +135,27 @@ std::string default_cache_path() {
     return "cbonsai";
 }
 
+std::string default_socket_path() {
+    const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir && *runtime_dir != '\0') {
+        return std::string(runtime_dir) + "/hbonsaid.sock";
+    }
+
+    return "/tmp/hbonsaid-" + std::to_string(getuid()) + ".sock";
+}
+
+bool invoked_as_daemon(const char* argv0) {
+    if (!argv0) {
+        return false;
+    }
+    std::string name(argv0);
+    size_t slash = name.find_last_of('/');
+    if (slash != std::string::npos) {
+        name.erase(0, slash + 1);
+    }
+    return name == "hbonsaid";
+}
+
 bool load_progress(Config& config) {
     std::ifstream file(config.bonsai.loadFile);
     if (!file.is_open()) {
@@ -130,6 +204,9 @@ Config parse_args(int argc, char* argv[]) {
     Config config;
     config.bonsai.saveFile = default_cache_path();
     config.bonsai.loadFile = default_cache_path();
+    config.app.termcapsFile = default_termcaps_path();
+    config.app.socketPath = default_socket_path();
+    config.app.daemon = argc > 0 && invoked_as_daemon(argv[0]);
 
     std::string leavesInput = "&";
     std::string colorsInput = "2,3,10,11";
@@ -157,6 +234,31 @@ Config parse_args(int argc, char* argv[]) {
         {"load", optional_argument, nullptr, 'C'},
         {"verbose", no_argument, nullptr, 'v'},
         {"help", no_argument, nullptr, 'h'},
+        {"daemon", optional_argument, nullptr, kOptDaemon},
+        {"client", optional_argument, nullptr, kOptClient},
+        {"daemon-workers", required_argument, nullptr, kOptDaemonWorkers},
+        {"daemon-pool", required_argument, nullptr, kOptDaemonPool},
+        {"parallel", optional_argument, nullptr, kOptParallel},
+        {"checkpoint-interval", required_argument, nullptr, kOptCheckpointInterval},
+        {"checkpoint-memory", required_argument, nullptr, kOptCheckpointMemory},
+        {"backend", required_argument, nullptr, kOptBackend},
+        {"wind", optional_argument, nullptr, kOptWind},
+        {"falling-leaves", optional_argument, nullptr, kOptFallingLeaves},
+        {"seasons", optional_argument, nullptr, kOptSeasons},
+        {"whole-steps", no_argument, nullptr, kOptWholeSteps},
+        {"broadcast", required_argument, nullptr, kOptBroadcast},
+        {"pace", optional_argument, nullptr, kOptPace},
+        {"survey", required_argument, nullptr, kOptSurvey},
+        {"survey-size", required_argument, nullptr, kOptSurveySize},
+        {"survey-csv", no_argument, nullptr, kOptSurveyCsv},
+        {"find-seed", required_argument, nullptr, kOptFindSeed},
+        {"find-count", required_argument, nullptr, kOptFindCount},
+        {"find-limit", required_argument, nullptr, kOptFindLimit},
+        {"max-parts", required_argument, nullptr, kOptMaxParts},
+        {"max-branches", required_argument, nullptr, kOptMaxBranches},
+        {"max-memory", required_argument, nullptr, kOptMaxMemory},
+        {"max-time", required_argument, nullptr, kOptMaxTime},
+        {"alloc-stats", optional_argument, nullptr, kOptAllocStats},
         {nullptr, 0, nullptr, 0}
     };
 
@@ -201,6 +303,7 @@ Config parse_args(int argc, char* argv[]) {
             }
             double parsed = config.title.displaySeconds;
             if (parse_double(optarg, parsed) && parsed > 0.0) {
+                config.app.waitTime = parsed;
                 config.title.displaySeconds = parsed;
             } else {
                 std::cerr << "error: invalid wait time: '" << optarg << "'" << std::endl;
@@ -325,6 +428,255 @@ Config parse_args(int argc, char* argv[]) {
         case 'v':
             config.app.verbosity += 1;
             break;
+        case kOptDaemon:
+            config.app.daemon = true;
+            if (optarg) {
+                config.app.socketPath = optarg;
+            }
+            break;
+        case kOptClient:
+            config.app.client = true;
+            if (optarg) {
+                config.app.socketPath = optarg;
+            }
+            break;
+        case kOptDaemonWorkers: {
+            int parsed = config.app.daemonWorkers;
+            if (parse_int(optarg, parsed) && parsed > 0) {
+                config.app.daemonWorkers = parsed;
+            } else {
+                std::cerr << "error: invalid worker count: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptDaemonPool: {
+            int parsed = config.app.daemonPoolSize;
+            if (parse_int(optarg, parsed) && parsed > 0) {
+                config.app.daemonPoolSize = parsed;
+            } else {
+                std::cerr << "error: invalid pool size: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptParallel: {
+            config.bonsai.parallel = true;
+            if (!optarg) {
+                break;
+            }
+            int parsed = config.bonsai.threads;
+            if (parse_int(optarg, parsed) && parsed > 0) {
+                config.bonsai.threads = parsed;
+            } else {
+                std::cerr << "error: invalid thread count: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptCheckpointInterval: {
+            int parsed = config.app.checkpointInterval;
+            if (parse_int(optarg, parsed) && parsed > 0) {
+                config.app.checkpointInterval = parsed;
+            } else {
+                std::cerr << "error: invalid checkpoint interval: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptCheckpointMemory: {
+            int parsed = config.app.checkpointMemoryKb;
+            if (parse_int(optarg, parsed) && parsed >= 0) {
+                config.app.checkpointMemoryKb = parsed;
+            } else {
+                std::cerr << "error: invalid checkpoint memory: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptWind: {
+            config.app.windBudget = 24;
+            if (!optarg) {
+                break;
+            }
+            int parsed = config.app.windBudget;
+            if (parse_int(optarg, parsed) && parsed > 0) {
+                config.app.windBudget = parsed;
+            } else {
+                std::cerr << "error: invalid wind budget: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptFallingLeaves: {
+            config.app.fallingLeaves = 400;
+            if (!optarg) {
+                break;
+            }
+            int parsed = config.app.fallingLeaves;
+            if (parse_int(optarg, parsed) && parsed > 0 && parsed <= 65535) {
+                config.app.fallingLeaves = parsed;
+            } else {
+                std::cerr << "error: invalid falling leaves count: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptWholeSteps:
+            config.app.wholeSteps = true;
+            break;
+        case kOptSeasons: {
+            config.app.seasonPeriod = 120.0;
+            if (!optarg) {
+                break;
+            }
+            double parsed = config.app.seasonPeriod;
+            if (parse_double(optarg, parsed) && parsed > 0.0) {
+                config.app.seasonPeriod = parsed;
+            } else {
+                std::cerr << "error: invalid season period: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptBackend: {
+            std::string name = optarg;
+            if (name == "auto") {
+                config.app.backend = BackendKind::Auto;
+            } else if (name == "notcurses") {
+                config.app.backend = BackendKind::Notcurses;
+            } else if (name == "ansi") {
+                config.app.backend = BackendKind::Ansi;
+            } else {
+                std::cerr << "error: unknown backend: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptPace: {
+            config.app.pace = true;
+            if (!optarg) {
+                break;
+            }
+            double parsed = 0.0;
+            if (parse_double(optarg, parsed) && parsed > 0.0) {
+                config.app.paceSeconds = parsed;
+            } else {
+                std::cerr << "error: invalid pace: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptSurvey: {
+            long long parsed = 0;
+            if (parse_long(optarg, parsed) && parsed > 0) {
+                config.app.survey = parsed;
+            } else {
+                std::cerr << "error: invalid survey count: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptSurveySize: {
+            int rows = 0;
+            int cols = 0;
+            if (parse_size(optarg, rows, cols) && rows > 0 && rows <= 1000 && cols > 0 && cols <= 1000) {
+                config.app.surveyRows = rows;
+                config.app.surveyCols = cols;
+            } else {
+                std::cerr << "error: invalid survey size: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptSurveyCsv:
+            config.app.surveyCsv = true;
+            break;
+        case kOptFindSeed:
+            config.app.findSeed = split_list(optarg);
+            if (config.app.findSeed.empty()) {
+                std::cerr << "error: invalid seed constraints: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        case kOptFindCount: {
+            int parsed = config.app.findCount;
+            if (parse_int(optarg, parsed) && parsed > 0) {
+                config.app.findCount = parsed;
+            } else {
+                std::cerr << "error: invalid find count: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptFindLimit: {
+            long long parsed = 0;
+            if (parse_long(optarg, parsed) && parsed > 0) {
+                config.app.findLimit = parsed;
+            } else {
+                std::cerr << "error: invalid find limit: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptMaxParts: {
+            long long parsed = 0;
+            if (parse_long(optarg, parsed) && parsed >= 0) {
+                config.bonsai.maxParts = parsed;
+            } else {
+                std::cerr << "error: invalid parts budget: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptMaxBranches: {
+            int parsed = 0;
+            if (parse_int(optarg, parsed) && parsed >= 0) {
+                config.bonsai.maxBranches = parsed;
+            } else {
+                std::cerr << "error: invalid branch budget: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptMaxMemory: {
+            long long parsed = 0;
+            if (parse_long(optarg, parsed) && parsed >= 0) {
+                config.bonsai.maxMemoryKb = parsed;
+            } else {
+                std::cerr << "error: invalid memory budget: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptMaxTime: {
+            double parsed = 0.0;
+            if (parse_double(optarg, parsed) && parsed >= 0.0) {
+                config.bonsai.maxSeconds = parsed;
+            } else {
+                std::cerr << "error: invalid time budget: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptAllocStats: {
+            config.app.allocStats = true;
+            std::string format = optarg ? optarg : "text";
+            if (format == "text" || format == "json") {
+                config.app.allocStatsJson = format == "json";
+            } else {
+                std::cerr << "error: invalid alloc-stats format: '" << format << "'" << std::endl;
+                has_error = true;
+            }
+            break;
+        }
+        case kOptBroadcast:
+            config.app.broadcast = split_list(optarg);
+            if (config.app.broadcast.empty()) {
+                std::cerr << "error: invalid broadcast list: '" << optarg << "'" << std::endl;
+                has_error = true;
+            }
+            break;
         case 'h':
             config.showHelp = true;
             config.exitRequested = true;
@@ -335,6 +687,9 @@ Config parse_args(int argc, char* argv[]) {
                 config.bonsai.save = true;
             } else if (optopt == 'C') {
                 config.bonsai.load = true;
+            } else if (optopt >= kOptDaemon && optind > 0 && optind - 1 < argc) {
+                std::cerr << "error: option requires an argument -- '" << argv[optind - 1] << "'" << std::endl;
+                has_error = true;
             } else {
                 std::cerr << "error: option requires an argument -- '" << static_cast<char>(optopt) << "'" << std::endl;
                 has_error = true;
@@ -396,6 +751,24 @@ Config parse_args(int argc, char* argv[]) {
         }
     }
 
+    if ((config.app.survey > 0 || !config.app.findSeed.empty()) && config.bonsai.parallel) {
+        std::cerr << "error: --survey and --find-seed use the serial generator; drop --parallel" << std::endl;
+        set_error(config, 1, false);
+        return config;
+    }
+
+    if ((config.app.daemon || config.app.client) && config.bonsai.parallel) {
+        std::cerr << "error: hbonsaid serves trees from the serial generator; drop --parallel" << std::endl;
+        set_error(config, 1, false);
+        return config;
+    }
+
+    if (config.app.allocStats && (config.app.daemon || config.app.client)) {
+        std::cerr << "error: --alloc-stats cannot be combined with --daemon or --client" << std::endl;
+        set_error(config, 1, false);
+        return config;
+    }
+
     return config;
 }
 
@@ -408,6 +781,21 @@ void print_help(std::ostream& os) {
        << "  -l, --live             live mode: show each step of growth\n"
        << "  -t, --time=TIME        in live mode, wait TIME secs between\n"
        << "                           steps of growth (must be larger than 0) [default: 0.03]\n"
+       << "      --pace[=SECS]      in live mode, grow each tree in SECS seconds whatever\n"
+       << "                           the terminal's speed, batching parts on slow links\n"
+       << "                           [default: number of parts times --time]\n"
+       << "      --whole-steps      in live mode, draw all glyphs of a growth step\n"
+       << "                           at once, like cbonsai, instead of one per step\n"
+       << "      --checkpoint-interval=INT  in live mode, keep a seek checkpoint\n"
+       << "                           every INT parts [default: 256]\n"
+       << "      --checkpoint-memory=KB  cap seek checkpoint memory at KB kilobytes;\n"
+       << "                           the interval grows to fit [default: 4096]\n"
+       << "      --wind[=BUDGET]    sway leaves once the tree has grown, moving at most\n"
+       << "                           BUDGET leaf cells per frame [default: 24]\n"
+       << "      --falling-leaves[=MAX]  once grown, leaves drop off the tree and pile up\n"
+       << "                           on the pot, at most MAX in the air (1-65535) [default: 400]\n"
+       << "      --seasons[=SECS]   cycle the tree's colours through the seasons,\n"
+       << "                           once every SECS seconds [default: 120]\n"
        << "  -i, --infinite         infinite mode: keep growing trees\n"
        << "  -w, --wait=TIME        in infinite mode, wait TIME between each tree\n"
        << "                           generation [default: 4.00]\n"
@@ -425,10 +813,47 @@ void print_help(std::ostream& os) {
        << "                           branching (0-20) [default: 5]\n"
        << "  -L, --life=INT         life; higher -> more growth (0-200) [default: 32]\n"
        << "  -p, --print            print tree to terminal when finished\n"
+       << "      --parallel[=INT]   grow subtrees on INT threads [default: all cores];\n"
+       << "                           reproducible per seed, but not the same trees as\n"
+       << "                           the default serial generator\n"
        << "  -s, --seed=INT         seed random number generator\n"
+       << "      --max-parts=INT    stop growing a tree at about INT parts; 0 for no\n"
+       << "                           limit [default: 2000000]\n"
+       << "      --max-branches=INT stop growing a tree after INT branches [default: 0,\n"
+       << "                           no limit]\n"
+       << "      --max-memory=KB    stop growing a tree once its parts would need more\n"
+       << "                           than KB kilobytes [default: 0, no limit]\n"
+       << "      --max-time=SECS    stop growing a tree after SECS seconds [default: 0,\n"
+       << "                           no limit]\n"
        << "  -W, --save[=FILE]      save progress to file [default: $XDG_CACHE_HOME/cbonsai or $HOME/.cache/cbonsai]\n"
        << "  -C, --load[=FILE]      load progress from file [default: $XDG_CACHE_HOME/cbonsai]\n"
        << "  -v, --verbose          increase output verbosity\n"
+       << "      --alloc-stats[=json]  on exit, print allocation counts, bytes and peak\n"
+       << "                           live bytes for each phase of the run to stderr,\n"
+       << "                           as a table or as JSON\n"
+       << "      --survey=COUNT     instead of drawing, count COUNT trees with consecutive\n"
+       << "                           seeds from --seed (or 1) on every core and print\n"
+       << "                           histograms of their size, parts and branches;\n"
+       << "                           about 2.6x faster per tree than full generation\n"
+       << "      --survey-size=ROWSxCOLS  terminal size for --survey and --find-seed\n"
+       << "                           [default: 24x80]\n"
+       << "      --survey-csv       with --survey, print one CSV row per tree instead\n"
+       << "      --find-seed=LIST   print seeds from --seed (or 1) whose trees meet every\n"
+       << "                           constraint in a comma-delimited list such as\n"
+       << "                           width>=80%,edge=0,shoots>=4; see README\n"
+       << "      --find-count=INT   seeds --find-seed looks for [default: 1]\n"
+       << "      --find-limit=INT   seeds --find-seed tries at most [default: 100000000]\n"
+       << "      --backend=NAME     terminal output: notcurses, ansi for plain escape\n"
+       << "                           sequences without terminal probing, or auto to use\n"
+       << "                           ansi once notcurses has probed this terminal type\n"
+       << "                           [default: notcurses]\n"
+       << "      --broadcast=LIST   show the tree on every terminal in a comma-delimited\n"
+       << "                           list of tty/pty paths instead of this one\n"
+       << "      --daemon[=SOCKET]  run as hbonsaid: serve rendered trees on a Unix socket\n"
+       << "                           [default: $XDG_RUNTIME_DIR/hbonsaid.sock]\n"
+       << "      --client[=SOCKET]  print a tree fetched from hbonsaid and exit\n"
+       << "      --daemon-workers=INT  background refill threads for hbonsaid [default: 2]\n"
+       << "      --daemon-pool=INT  trees kept ready per terminal size [default: 8]\n"
        << "  -h, --help             show help\n";
 }
 
@@ -0,0 +1,602 @@
+#include "hbonsai/daemon.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "hbonsai/ansi.h"
+#include "hbonsai/bonsai.h"
+#include "hbonsai/layout.h"
+
+namespace hbonsai {
+namespace {
+
+constexpr const char* kProtocolTag = "HB1";
+constexpr size_t kMaxRequestBytes = 4096;
+constexpr size_t kMaxPools = 64;
+constexpr int kMaxDimension = 1000;
+constexpr int kPollIntervalMs = 500;
+constexpr int kRequestTimeoutMs = 1000; // for a client to send its request, and again to take the tree
+constexpr size_t kMaxConnections = 256; // waiting for their request; more wait in the listen backlog
+constexpr int kReplyThreads = 4;
+
+// Terminal sizes that are pre-filled with the daemon's own parameters at startup.
+constexpr std::pair<int, int> kCommonSizes[] = {{24, 80}, {40, 120}, {50, 160}};
+
+volatile std::sig_atomic_t g_stopRequested = 0;
+
+void handle_stop_signal(int) {
+    g_stopRequested = 1;
+}
+
+struct TreeRequest {
+    int rows = 24;
+    int cols = 80;
+    BonsaiConfig bonsai;
+};
+
+std::string join(const std::vector<std::string>& items, char separator) {
+    std::string result;
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (i > 0) {
+            result.push_back(separator);
+        }
+        result += items[i];
+    }
+    return result;
+}
+
+std::vector<std::string> split(const std::string& input, char separator) {
+    std::vector<std::string> result;
+    std::stringstream ss(input);
+    std::string item;
+    while (std::getline(ss, item, separator)) {
+        result.push_back(item);
+    }
+    return result;
+}
+
+std::string sanitize_field(std::string value) {
+    std::replace(value.begin(), value.end(), '\t', ' ');
+    std::replace(value.begin(), value.end(), '\n', ' ');
+    return value;
+}
+
+// Everything that influences the rendered tree except the seed, tab separated.
+std::string encode_parameters(const TreeRequest& request) {
+    const BonsaiConfig& bonsai = request.bonsai;
+    std::string fields;
+    fields += std::to_string(request.rows) + '\t' + std::to_string(request.cols) + '\t';
+    fields += std::to_string(bonsai.lifeStart) + '\t' + std::to_string(bonsai.multiplier) + '\t';
+    fields += std::to_string(bonsai.baseType) + '\t';
+    fields += std::to_string(bonsai.colors[0]) + ',' + std::to_string(bonsai.colors[1]) + ',' +
+              std::to_string(bonsai.colors[2]) + ',' + std::to_string(bonsai.colors[3]) + '\t';
+    fields += sanitize_field(join(bonsai.leaves, ',')) + '\t';
+    fields += sanitize_field(bonsai.message);
+    return fields;
+}
+
+std::string encode_request(const TreeRequest& request) {
+    return std::string(kProtocolTag) + '\t' + std::to_string(request.bonsai.seed) + '\t' +
+           encode_parameters(request) + '\n';
+}
+
+bool parse_field(const std::string& value, int& out) {
+    try {
+        size_t idx = 0;
+        out = std::stoi(value, &idx, 10);
+        return idx == value.size();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool decode_request(const std::string& line, TreeRequest& request) {
+    std::vector<std::string> fields = split(line, '\t');
+    if (fields.size() == 9) {
+        fields.emplace_back(); // empty message
+    }
+    if (fields.size() != 10 || fields[0] != kProtocolTag) {
+        return false;
+    }
+
+    BonsaiConfig& bonsai = request.bonsai;
+    if (!parse_field(fields[1], bonsai.seed) || !parse_field(fields[2], request.rows) ||
+        !parse_field(fields[3], request.cols) || !parse_field(fields[4], bonsai.lifeStart) ||
+        !parse_field(fields[5], bonsai.multiplier) || !parse_field(fields[6], bonsai.baseType)) {
+        return false;
+    }
+
+    std::vector<std::string> colors = split(fields[7], ',');
+    if (colors.size() != bonsai.colors.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < colors.size(); ++i) {
+        if (!parse_field(colors[i], bonsai.colors[i]) || bonsai.colors[i] < 0 || bonsai.colors[i] >= 256) {
+            return false;
+        }
+    }
+
+    bonsai.leaves.clear();
+    for (auto& leaf : split(fields[8], ',')) {
+        if (!leaf.empty()) {
+            bonsai.leaves.push_back(std::move(leaf));
+        }
+    }
+    if (bonsai.leaves.empty()) {
+        bonsai.leaves = {"&"};
+    }
+    bonsai.message = fields[9];
+
+    // Life and multiplier take the ranges parse_args() does; the daemon's own
+    // generation budgets are what bound the work a request can ask for.
+    return request.rows > 0 && request.rows <= kMaxDimension && request.cols > 0 &&
+           request.cols <= kMaxDimension && bonsai.lifeStart > 0 && bonsai.multiplier > 0 && bonsai.baseType >= 0 &&
+           bonsai.seed >= 0;
+}
+
+std::string render_request(Bonsai& bonsai, const TreeRequest& request) {
+    int baseHeight = base_dimensions(request.bonsai.baseType).first;
+    int treeHeight = std::max(1, request.rows - baseHeight);
+    auto parts = bonsai.generate(treeHeight, request.cols);
+    return render_ansi(parts, request.bonsai, request.rows, request.cols);
+}
+
+bool write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool make_address(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+int connect_socket(const std::string& path) {
+    sockaddr_un address;
+    if (!make_address(path, address)) {
+        return -1;
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+class TreeServer {
+public:
+    explicit TreeServer(const Config& config) : config_(config) {}
+    ~TreeServer();
+
+    int run();
+
+private:
+    // A client whose request has not fully arrived yet.
+    struct Connection {
+        int fd = -1;
+        std::string line;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    // A parsed request, waiting for a reply thread.
+    struct Reply {
+        int fd = -1;
+        TreeRequest request;
+    };
+
+    struct Pool {
+        TreeRequest request;
+        std::unique_ptr<Bonsai> generator; // refers to request.bonsai
+        std::mutex generateMutex;
+        std::deque<std::string> ready;
+        int inFlight = 0;
+    };
+
+    bool openSocket();
+    Pool* poolFor(const TreeRequest& request);
+    std::string take(const TreeRequest& request);
+    std::string generate(Pool& pool);
+    void refillLoop();
+    // Reads what has arrived for one connection. True once the connection is
+    // finished with here: handed on to a reply thread, or closed.
+    bool readRequest(Connection& connection);
+    void replyLoop();
+
+    const Config& config_;
+    int listenFd_ = -1;
+    std::mutex mutex_;
+    std::condition_variable refill_;
+    std::condition_variable replyReady_;
+    std::unordered_map<std::string, std::unique_ptr<Pool>> pools_;
+    std::deque<Reply> replies_;
+    std::vector<std::thread> workers_;
+    std::vector<std::thread> replyThreads_;
+    bool stopping_ = false;
+};
+
+TreeServer::~TreeServer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    refill_.notify_all();
+    replyReady_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    for (auto& thread : replyThreads_) {
+        thread.join();
+    }
+    for (const Reply& reply : replies_) {
+        ::close(reply.fd);
+    }
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        ::unlink(config_.app.socketPath.c_str());
+    }
+}
+
+bool TreeServer::openSocket() {
+    const std::string& path = config_.app.socketPath;
+    sockaddr_un address;
+    if (!make_address(path, address)) {
+        std::cerr << "error: invalid socket path: '" << path << "'" << std::endl;
+        return false;
+    }
+
+    int existing = connect_socket(path);
+    if (existing >= 0) {
+        ::close(existing);
+        std::cerr << "error: hbonsaid is already listening on " << path << std::endl;
+        return false;
+    }
+    ::unlink(path.c_str()); // stale socket from a previous run
+
+    listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "error: socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Only the owning user may talk to the daemon.
+    mode_t previousMask = ::umask(0077);
+    int bound = ::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    ::umask(previousMask);
+    if (bound != 0 || ::listen(listenFd_, 64) != 0) {
+        std::cerr << "error: cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+TreeServer::Pool* TreeServer::poolFor(const TreeRequest& request) {
+    std::string key = encode_parameters(request);
+    auto it = pools_.find(key);
+    if (it != pools_.end()) {
+        return it->second.get();
+    }
+    if (pools_.size() >= kMaxPools) {
+        return nullptr;
+    }
+
+    auto pool = std::make_unique<Pool>();
+    pool->request = request;
+    pool->request.bonsai.seed = 0;
+    pool->generator = std::make_unique<Bonsai>(pool->request.bonsai);
+    Pool* result = pool.get();
+    pools_.emplace(std::move(key), std::move(pool));
+    refill_.notify_all();
+    return result;
+}
+
+std::string TreeServer::generate(Pool& pool) {
+    std::lock_guard<std::mutex> lock(pool.generateMutex);
+    return render_request(*pool.generator, pool.request);
+}
+
+std::string TreeServer::take(const TreeRequest& request) {
+    if (request.bonsai.seed != 0) {
+        // Seeded trees are reproducible, so there is nothing to pre-generate.
+        Bonsai bonsai(request.bonsai);
+        return render_request(bonsai, request);
+    }
+
+    Pool* pool = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pool = poolFor(request);
+        if (pool && !pool->ready.empty()) {
+            std::string tree = std::move(pool->ready.front());
+            pool->ready.pop_front();
+            refill_.notify_one();
+            return tree;
+        }
+    }
+
+    if (pool) {
+        return generate(*pool);
+    }
+    Bonsai bonsai(request.bonsai);
+    return render_request(bonsai, request);
+}
+
+void TreeServer::refillLoop() {
+    const size_t target = static_cast<size_t>(config_.app.daemonPoolSize);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        // Refill the emptiest pool first so a burst on one size cannot starve the rest.
+        Pool* pool = nullptr;
+        size_t lowest = target;
+        for (auto& entry : pools_) {
+            size_t level = entry.second->ready.size() + static_cast<size_t>(entry.second->inFlight);
+            if (level < lowest) {
+                lowest = level;
+                pool = entry.second.get();
+            }
+        }
+        if (!pool) {
+            refill_.wait(lock);
+            continue;
+        }
+
+        pool->inFlight++;
+        lock.unlock();
+        std::string tree = generate(*pool);
+        lock.lock();
+        pool->inFlight--;
+        pool->ready.push_back(std::move(tree));
+    }
+}
+
+bool TreeServer::readRequest(Connection& connection) {
+    char buffer[512];
+    ssize_t received = ::read(connection.fd, buffer, sizeof(buffer));
+    if (received < 0 && errno == EINTR) {
+        return false;
+    }
+    if (received > 0) {
+        connection.line.append(buffer, static_cast<size_t>(received));
+    }
+    size_t newline = connection.line.find('\n');
+    if (newline == std::string::npos) {
+        if (received > 0 && connection.line.size() < kMaxRequestBytes) {
+            return false;
+        }
+        ::close(connection.fd);
+        return true;
+    }
+    connection.line.resize(newline);
+
+    Reply reply;
+    reply.fd = connection.fd;
+    if (!decode_request(connection.line, reply.request)) {
+        if (config_.app.verbosity > 0) {
+            std::cerr << "hbonsaid: rejected malformed request" << std::endl;
+        }
+        ::close(connection.fd);
+        return true;
+    }
+    // Budgets are the daemon's to set, not the client's.
+    reply.request.bonsai.maxParts = config_.bonsai.maxParts;
+    reply.request.bonsai.maxBranches = config_.bonsai.maxBranches;
+    reply.request.bonsai.maxMemoryKb = config_.bonsai.maxMemoryKb;
+    reply.request.bonsai.maxSeconds = config_.bonsai.maxSeconds;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        replies_.push_back(std::move(reply));
+    }
+    replyReady_.notify_one();
+    return true;
+}
+
+void TreeServer::replyLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        replyReady_.wait(lock, [this] { return stopping_ || !replies_.empty(); });
+        if (stopping_) {
+            return;
+        }
+        Reply reply = std::move(replies_.front());
+        replies_.pop_front();
+        lock.unlock();
+
+        std::string tree = take(reply.request);
+        write_all(reply.fd, tree.data(), tree.size());
+        ::close(reply.fd);
+
+        lock.lock();
+    }
+}
+
+int TreeServer::run() {
+    if (!openSocket()) {
+        return 1;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto [rows, cols] : kCommonSizes) {
+            TreeRequest request;
+            request.rows = rows;
+            request.cols = cols;
+            request.bonsai = config_.bonsai;
+            poolFor(request);
+        }
+    }
+    for (int i = 0; i < config_.app.daemonWorkers; ++i) {
+        workers_.emplace_back(&TreeServer::refillLoop, this);
+    }
+    for (int i = 0; i < kReplyThreads; ++i) {
+        replyThreads_.emplace_back(&TreeServer::replyLoop, this);
+    }
+
+    if (config_.app.verbosity > 0) {
+        std::cerr << "hbonsaid: listening on " << config_.app.socketPath << std::endl;
+    }
+
+    // One thread multiplexes every client still sending its request, so a
+    // slow or stalled one never holds up the rest; complete requests go to
+    // the reply threads.
+    std::vector<Connection> connections;
+    std::vector<pollfd> fds;
+    while (!g_stopRequested) {
+        auto now = std::chrono::steady_clock::now();
+        int timeoutMs = kPollIntervalMs;
+        fds.clear();
+        // poll() skips negative descriptors: at the limit, new clients wait in the backlog.
+        fds.push_back({connections.size() < kMaxConnections ? listenFd_ : -1, POLLIN, 0});
+        for (const Connection& connection : connections) {
+            fds.push_back({connection.fd, POLLIN, 0});
+            auto left = std::chrono::ceil<std::chrono::milliseconds>(connection.deadline - now).count();
+            timeoutMs = static_cast<int>(std::clamp<long long>(left, 0, timeoutMs));
+        }
+        int ready = ::poll(fds.data(), fds.size(), timeoutMs);
+        if (ready < 0) {
+            continue;
+        }
+
+        now = std::chrono::steady_clock::now();
+        size_t kept = 0;
+        for (size_t i = 0; i < connections.size(); ++i) {
+            Connection& connection = connections[i];
+            bool finished = false;
+            if (fds[i + 1].revents != 0) {
+                finished = readRequest(connection);
+            } else if (now >= connection.deadline) {
+                ::close(connection.fd);
+                finished = true;
+            }
+            if (!finished) {
+                connections[kept++] = std::move(connection);
+            }
+        }
+        connections.resize(kept);
+
+        if (fds[0].revents & POLLIN) {
+            int client = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client >= 0) {
+                // Nor may a client that stops reading hold up a reply thread for long.
+                timeval timeout{kRequestTimeoutMs / 1000, (kRequestTimeoutMs % 1000) * 1000};
+                ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                Connection connection;
+                connection.fd = client;
+                connection.deadline = now + std::chrono::milliseconds(kRequestTimeoutMs);
+                connections.push_back(std::move(connection));
+            }
+        }
+    }
+
+    for (const Connection& connection : connections) {
+        ::close(connection.fd);
+    }
+    return 0;
+}
+
+} // namespace
+
+int run_daemon(const Config& config) {
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, handle_stop_signal);
+    std::signal(SIGTERM, handle_stop_signal);
+
+    TreeServer server(config);
+    return server.run();
+}
+
+bool fetch_tree(const std::string& socketPath, const BonsaiConfig& bonsai, int rows, int cols, std::string& tree) {
+    tree.clear();
+    int fd = connect_socket(socketPath);
+    if (fd < 0) {
+        return false;
+    }
+    TreeRequest request;
+    request.rows = rows;
+    request.cols = cols;
+    request.bonsai = bonsai;
+    std::string message = encode_request(request);
+    bool ok = write_all(fd, message.data(), message.size());
+
+    char buffer[65536];
+    while (ok) {
+        ssize_t count = ::read(fd, buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        tree.append(buffer, static_cast<size_t>(count));
+    }
+    ::close(fd);
+    return ok && !tree.empty();
+}
+
+int run_client(const Config& config) {
+    TreeRequest request;
+    request.bonsai = config.bonsai;
+
+    winsize size{};
+    if (::ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0) {
+        request.rows = std::min<int>(size.ws_row, kMaxDimension);
+        request.cols = std::min<int>(size.ws_col, kMaxDimension);
+    }
+
+    std::string tree;
+    if (!fetch_tree(config.app.socketPath, request.bonsai, request.rows, request.cols, tree)) {
+        // No daemon, or one that turned the request down or went away: draw
+        // the tree here instead.
+        if (config.app.verbosity > 0) {
+            std::cerr << "hbonsai: no tree from hbonsaid on " << config.app.socketPath << std::endl;
+        }
+        Bonsai bonsai(request.bonsai);
+        tree = render_request(bonsai, request);
+    }
+    return write_all(STDOUT_FILENO, tree.data(), tree.size()) ? 0 : 1;
+}
+
+} // namespace hbonsai
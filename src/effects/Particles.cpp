@@ -0,0 +1,224 @@
+#include "hbonsai/particles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace hbonsai {
+namespace {
+
+constexpr std::uint32_t kBlank = std::numeric_limits<std::uint32_t>::max();
+constexpr std::uint32_t kPileBit = 0x80000000u; // settled leaf, drawn at its cell
+constexpr float kStep = 1.0f / 60.0f;           // physics step, seconds
+constexpr int kMaxStepsPerUpdate = 15;          // drop time rather than spiral after a stall
+constexpr float kGravity = 6.0f;                // rows per second squared
+constexpr float kTerminalVelocity = 5.0f;       // rows per second
+constexpr float kDrift = 2.5f;                  // peak sideways speed, columns per second
+constexpr int kMaxPile = 2;                     // rows of settled leaves per column
+constexpr double kSpawnPerSecond = 0.25;        // fraction of the capacity released per second
+
+} // namespace
+
+LeafParticles::LeafParticles(int capacity) {
+    std::size_t size = static_cast<std::size_t>(std::max(0, capacity));
+    posX_.resize(size);
+    posY_.resize(size);
+    velY_.resize(size);
+    phase_.resize(size);
+    glyph_.resize(size);
+    cell_.resize(size);
+}
+
+void LeafParticles::build(const std::vector<TreePart>& parts, const PartIndex& index, int rows, int cols) {
+    parts_ = &parts;
+    rows_ = std::max(0, rows);
+    cols_ = std::max(0, cols);
+    accumulator_ = 0.0;
+    spawnCredit_ = 0.0;
+    time_ = 0.0f;
+    alive_ = 0;
+
+    std::size_t cells = static_cast<std::size_t>(rows_) * static_cast<std::size_t>(cols_);
+    background_.assign(cells, kBlank);
+    crowd_.assign(cells, 0);
+    floor_.assign(static_cast<std::size_t>(cols_), rows_);
+    sources_.clear();
+
+    index.forEachInRows(0, rows_ - 1, [&](std::size_t partIndex) {
+        const TreePart& part = parts[partIndex];
+        if (part.x < 0 || part.x >= cols_) {
+            return;
+        }
+        for (int i = 0; i < part.width && part.x + i < cols_; ++i) {
+            background_[static_cast<std::size_t>(part.y * cols_ + part.x + i)] = static_cast<std::uint32_t>(partIndex);
+        }
+    });
+    for (std::size_t cell = 0; cell < cells; ++cell) {
+        std::uint32_t index = background_[cell];
+        if (index != kBlank && parts[index].leaf && parts[index].width == 1) {
+            sources_.push_back(index);
+        }
+    }
+}
+
+void LeafParticles::step(double dt, std::vector<TreePart>& dirty) {
+    if (!parts_ || sources_.empty() || posX_.empty()) {
+        return;
+    }
+
+    accumulator_ += dt;
+    int steps = 0;
+    while (accumulator_ >= kStep) {
+        accumulator_ -= kStep;
+        if (++steps > kMaxStepsPerUpdate) {
+            accumulator_ = 0.0;
+            break;
+        }
+        integrate(kStep);
+        spawnCredit_ += kSpawnPerSecond * kStep * static_cast<double>(posX_.size());
+        while (spawnCredit_ >= 1.0 && alive_ < posX_.size()) {
+            spawn();
+            spawnCredit_ -= 1.0;
+        }
+        spawnCredit_ = std::min(spawnCredit_, 1.0);
+    }
+
+    // Work out which cell every particle is in now; only particles that
+    // changed cell produce output.
+    std::size_t slot = 0;
+    while (slot < alive_) {
+        int x = static_cast<int>(std::floor(posX_[slot]));
+        int y = static_cast<int>(std::floor(posY_[slot]));
+        if (x < 0 || x >= cols_) {
+            despawn(slot, dirty);
+            continue; // the last live particle moved into this slot
+        }
+
+        int floorRow = floor_[static_cast<std::size_t>(x)];
+        if (y >= floorRow - 1 && floorRow > 0) {
+            // Landed. Settle on the pile if there is room on a blank cell,
+            // otherwise the leaf just disappears.
+            int restCell = (floorRow - 1) * cols_ + x;
+            bool room = floorRow > rows_ - kMaxPile && background_[static_cast<std::size_t>(restCell)] == kBlank;
+            if (room) {
+                std::uint32_t glyph = glyph_[slot];
+                despawn(slot, dirty);
+                background_[static_cast<std::size_t>(restCell)] = glyph | kPileBit;
+                floor_[static_cast<std::size_t>(x)] = floorRow - 1;
+                if (crowd_[static_cast<std::size_t>(restCell)] == 0) {
+                    drawBackground(restCell, dirty);
+                }
+            } else {
+                despawn(slot, dirty);
+            }
+            continue;
+        }
+
+        int cell = std::max(0, y) * cols_ + x;
+        if (cell != cell_[slot]) {
+            leave(cell_[slot], dirty);
+            cell_[slot] = cell;
+            enter(cell, glyph_[slot], dirty);
+        }
+        ++slot;
+    }
+}
+
+void LeafParticles::spawn() {
+    std::uint32_t source = sources_[rng_() % sources_.size()];
+    const TreePart& part = (*parts_)[source];
+    std::size_t slot = alive_++;
+    posX_[slot] = static_cast<float>(part.x) + 0.5f;
+    posY_[slot] = static_cast<float>(part.y) + 0.5f;
+    velY_[slot] = 0.0f;
+    phase_[slot] = static_cast<float>(rng_() % 628) / 100.0f;
+    glyph_[slot] = source;
+    // It starts on top of its own source leaf, so there is nothing to draw yet.
+    int cell = part.y * cols_ + part.x;
+    ++crowd_[static_cast<std::size_t>(cell)];
+    cell_[slot] = cell;
+}
+
+void LeafParticles::integrate(float h) {
+    time_ += h;
+    const std::size_t count = alive_;
+    float* x = posX_.data();
+    float* y = posY_.data();
+    float* vy = velY_.data();
+    const float* phase = phase_.data();
+    for (std::size_t i = 0; i < count; ++i) {
+        vy[i] = std::min(vy[i] + kGravity * h, kTerminalVelocity);
+        y[i] += vy[i] * h;
+        x[i] += kDrift * std::sin(time_ * 1.3f + phase[i]) * h;
+    }
+}
+
+void LeafParticles::redraw(std::vector<TreePart>& dirty) const {
+    if (!parts_) {
+        return;
+    }
+    for (std::size_t cell = 0; cell < background_.size(); ++cell) {
+        if (background_[cell] != kBlank && (background_[cell] & kPileBit)) {
+            drawBackground(static_cast<int>(cell), dirty);
+        }
+    }
+    for (std::size_t slot = 0; slot < alive_; ++slot) {
+        if (cell_[slot] < 0) {
+            continue;
+        }
+        TreePart part = (*parts_)[glyph_[slot]];
+        part.y = cell_[slot] / cols_;
+        part.x = cell_[slot] % cols_;
+        dirty.push_back(part);
+    }
+}
+
+void LeafParticles::despawn(std::size_t slot, std::vector<TreePart>& dirty) {
+    leave(cell_[slot], dirty);
+    std::size_t last = --alive_;
+    if (slot != last) {
+        posX_[slot] = posX_[last];
+        posY_[slot] = posY_[last];
+        velY_[slot] = velY_[last];
+        phase_[slot] = phase_[last];
+        glyph_[slot] = glyph_[last];
+        cell_[slot] = cell_[last];
+    }
+}
+
+void LeafParticles::enter(int cell, std::uint32_t glyph, std::vector<TreePart>& dirty) {
+    ++crowd_[static_cast<std::size_t>(cell)];
+    TreePart part = (*parts_)[glyph];
+    part.y = cell / cols_;
+    part.x = cell % cols_;
+    dirty.push_back(part);
+}
+
+void LeafParticles::leave(int cell, std::vector<TreePart>& dirty) {
+    if (cell < 0) {
+        return;
+    }
+    if (--crowd_[static_cast<std::size_t>(cell)] == 0) {
+        drawBackground(cell, dirty);
+    }
+}
+
+void LeafParticles::drawBackground(int cell, std::vector<TreePart>& dirty) const {
+    std::uint32_t value = background_[static_cast<std::size_t>(cell)];
+    TreePart part;
+    if (value == kBlank) {
+        part.colorIndex = -1;
+        part.y = cell / cols_;
+        part.x = cell % cols_;
+    } else if (value & kPileBit) {
+        part = (*parts_)[value & ~kPileBit];
+        part.y = cell / cols_;
+        part.x = cell % cols_;
+    } else {
+        // Tree parts keep their own origin so a wide glyph is redrawn whole.
+        part = (*parts_)[value];
+    }
+    dirty.push_back(part);
+}
+
+} // namespace hbonsai
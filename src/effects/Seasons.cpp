@@ -0,0 +1,151 @@
+#include "hbonsai/seasons.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "hbonsai/renderer.h"
+
+namespace hbonsai {
+namespace {
+
+constexpr std::uint8_t kNoRole = 0xff;
+
+// Keyframes at the start of spring, summer, autumn and winter, in role order.
+constexpr std::array<std::array<std::uint32_t, 4>, 4> kSeasons = {{
+    {0x3a8c2a, 0x5a3a1a, 0x9cd85a, 0x8a5a2a}, // spring: fresh greens
+    {0x1e6b1e, 0x5a3a1a, 0x4cb03c, 0x8a5a2a}, // summer: deep greens
+    {0xb04010, 0x5a3a1a, 0xf0a020, 0x8a5a2a}, // autumn: rust and gold
+    {0x6a6a5a, 0x4a3a2a, 0xd8e8f0, 0x7a6a5a}, // winter: bare, frosted
+}};
+
+std::uint32_t mix(std::uint32_t a, std::uint32_t b, double t) {
+    std::uint32_t out = 0;
+    for (int shift = 16; shift >= 0; shift -= 8) {
+        double ca = static_cast<double>((a >> shift) & 0xff);
+        double cb = static_cast<double>((b >> shift) & 0xff);
+        out |= static_cast<std::uint32_t>(std::lround(ca + (cb - ca) * t)) << shift;
+    }
+    return out;
+}
+
+int distance(std::uint32_t a, int r, int g, int b) {
+    int dr = static_cast<int>((a >> 16) & 0xff) - r;
+    int dg = static_cast<int>((a >> 8) & 0xff) - g;
+    int db = static_cast<int>(a & 0xff) - b;
+    return dr * dr + dg * dg + db * db;
+}
+
+} // namespace
+
+std::array<std::uint32_t, 4> season_colors(double phase) {
+    phase -= std::floor(phase);
+    double position = phase * static_cast<double>(kSeasons.size());
+    std::size_t from = static_cast<std::size_t>(position) % kSeasons.size();
+    std::size_t to = (from + 1) % kSeasons.size();
+    double t = position - std::floor(position);
+
+    std::array<std::uint32_t, 4> colors{};
+    for (std::size_t role = 0; role < colors.size(); ++role) {
+        colors[role] = mix(kSeasons[from][role], kSeasons[to][role], t);
+    }
+    return colors;
+}
+
+int nearest_xterm_index(std::uint32_t rgb) {
+    static constexpr int kLevels[6] = {0, 95, 135, 175, 215, 255};
+    auto level = [](int channel) {
+        int best = 0;
+        for (int i = 1; i < 6; ++i) {
+            if (std::abs(kLevels[i] - channel) < std::abs(kLevels[best] - channel)) {
+                best = i;
+            }
+        }
+        return best;
+    };
+
+    int r = static_cast<int>((rgb >> 16) & 0xff);
+    int g = static_cast<int>((rgb >> 8) & 0xff);
+    int b = static_cast<int>(rgb & 0xff);
+
+    // Best entry of the 6x6x6 cube and of the 24-step grey ramp.
+    int cr = level(r);
+    int cg = level(g);
+    int cb = level(b);
+    int cubeIndex = 16 + 36 * cr + 6 * cg + cb;
+    int cubeDistance = distance(rgb, kLevels[cr], kLevels[cg], kLevels[cb]);
+
+    int grey = std::clamp((r + g + b) / 3, 8, 238);
+    int step = std::clamp((grey - 8 + 5) / 10, 0, 23);
+    int greyValue = 8 + 10 * step;
+    int greyDistance = distance(rgb, greyValue, greyValue, greyValue);
+
+    return greyDistance < cubeDistance ? 232 + step : cubeIndex;
+}
+
+SeasonCycle::SeasonCycle(double period, const std::array<int, 4>& indices)
+    : period_(period), indices_(indices), fallbackIndices_(indices) {}
+
+void SeasonCycle::reset(const std::vector<TreePart>& parts) {
+    roles_.assign(parts.size(), kNoRole);
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        for (std::size_t role = 0; role < indices_.size(); ++role) {
+            if (parts[i].colorIndex == indices_[role]) {
+                roles_[i] = static_cast<std::uint8_t>(role);
+                break;
+            }
+        }
+    }
+    // A fresh tree carries the configured indices again.
+    fallbackIndices_ = indices_;
+}
+
+void SeasonCycle::advance(double dt) {
+    time_ += dt;
+}
+
+bool SeasonCycle::apply(Renderer& renderer, std::vector<TreePart>& parts, std::size_t drawn,
+                        std::vector<TreePart>& dirty) {
+    if (period_ <= 0.0) {
+        return false;
+    }
+
+    std::array<std::uint32_t, 4> colors = season_colors(time_ / period_);
+    if (!fallback_) {
+        if (hasApplied_ && colors == applied_) {
+            return false;
+        }
+        std::vector<PaletteEntry> entries;
+        entries.reserve(colors.size());
+        for (std::size_t role = 0; role < colors.size(); ++role) {
+            entries.push_back(PaletteEntry{indices_[role], colors[role]});
+        }
+        if (renderer.setPalette(entries)) {
+            applied_ = colors;
+            hasApplied_ = true;
+            return false;
+        }
+        fallback_ = true;
+    }
+
+    std::array<int, 4> target{};
+    for (std::size_t role = 0; role < colors.size(); ++role) {
+        target[role] = nearest_xterm_index(colors[role]);
+    }
+    if (target == fallbackIndices_ || roles_.size() != parts.size()) {
+        return false;
+    }
+    fallbackIndices_ = target;
+
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        if (roles_[i] != kNoRole) {
+            parts[i].colorIndex = target[roles_[i]];
+        }
+    }
+    // Redraw in growth order so overlapping parts stack exactly as before.
+    drawn = std::min(drawn, parts.size());
+    dirty.insert(dirty.end(), parts.begin(), parts.begin() + static_cast<std::ptrdiff_t>(drawn));
+    return true;
+}
+
+} // namespace hbonsai
@@ -0,0 +1,155 @@
+#include "hbonsai/wind.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace hbonsai {
+namespace {
+
+constexpr std::int32_t kEmpty = -1;
+constexpr std::int32_t kWood = -2; // wood or wide glyphs: never moved or displaced
+constexpr std::uint32_t kNoPart = std::numeric_limits<std::uint32_t>::max();
+
+// Which way the wind pushes a leaf in the given row: a slow travelling wave
+// with a gust on top, quantised to -1, 0 or +1 columns.
+int sway_offset(double time, int row) {
+    double gust = std::sin(time * 0.9 - row * 0.3) + 0.6 * std::sin(time * 0.37);
+    if (gust > 0.9) {
+        return 1;
+    }
+    if (gust < -0.9) {
+        return -1;
+    }
+    return 0;
+}
+
+} // namespace
+
+WindEffect::WindEffect(int budget) : budget_(std::max(0, budget)) {}
+
+void WindEffect::build(const std::vector<TreePart>& parts, const PartIndex& index, int rows, int cols) {
+    rows_ = std::max(0, rows);
+    cols_ = std::max(0, cols);
+    time_ = 0.0;
+    cursor_ = 0;
+    leaves_.clear();
+    occupant_.assign(static_cast<std::size_t>(rows_) * static_cast<std::size_t>(cols_), kEmpty);
+
+    // One row at a time: the part that is visible in each cell of the row once
+    // the tree is fully drawn.
+    std::vector<std::uint32_t> owner(static_cast<std::size_t>(cols_));
+    for (int row = 0; row < rows_; ++row) {
+        std::fill(owner.begin(), owner.end(), kNoPart);
+        index.forEachInRows(row, row, [&](std::size_t partIndex) {
+            const TreePart& part = parts[partIndex];
+            if (part.x < 0 || part.x >= cols_) {
+                return;
+            }
+            for (int i = 0; i < part.width && part.x + i < cols_; ++i) {
+                owner[part.x + i] = static_cast<std::uint32_t>(partIndex);
+            }
+        });
+
+        for (int col = 0; col < cols_; ++col) {
+            if (owner[col] == kNoPart) {
+                continue;
+            }
+            int cell = row * cols_ + col;
+            const TreePart& part = parts[owner[col]];
+            if (!part.leaf || part.width != 1 || part.x != col) {
+                occupant_[cell] = kWood;
+                continue;
+            }
+            occupant_[cell] = static_cast<std::int32_t>(leaves_.size());
+            leaves_.push_back(Leaf{part, owner[col], cell, cell});
+        }
+    }
+
+    // Visit leaves in a scattered order so each frame's budget is spread over
+    // the whole crown rather than sweeping it row by row.
+    std::size_t count = leaves_.size();
+    stride_ = count > 2 ? count / 2 + 1 : 1;
+    while (count > 1 && std::gcd(stride_, count) != 1) {
+        ++stride_;
+    }
+}
+
+void WindEffect::step(double dt, std::vector<TreePart>& dirty) {
+    if (leaves_.empty() || budget_ == 0) {
+        return;
+    }
+    time_ += dt;
+
+    std::size_t visits = std::min(leaves_.size(), static_cast<std::size_t>(budget_));
+    for (std::size_t visit = 0; visit < visits; ++visit) {
+        cursor_ = (cursor_ + stride_) % leaves_.size();
+        Leaf& leaf = leaves_[cursor_];
+
+        int row = leaf.home / cols_;
+        int homeX = leaf.home % cols_;
+        int targetX = homeX + sway_offset(time_, row);
+        if (targetX < 0 || targetX >= cols_) {
+            targetX = homeX;
+        }
+        int target = row * cols_ + targetX;
+        if (target == leaf.pos) {
+            continue;
+        }
+
+        std::int32_t other = occupant_[target];
+        if (other == kWood) {
+            continue;
+        }
+
+        int from = leaf.pos;
+        occupant_[target] = static_cast<std::int32_t>(cursor_);
+        leaf.pos = target;
+        show(leaf, dirty);
+        if (other == kEmpty) {
+            occupant_[from] = kEmpty;
+            blank(from, dirty);
+        } else {
+            // Trade places with the leaf that was there.
+            Leaf& displaced = leaves_[static_cast<std::size_t>(other)];
+            occupant_[from] = other;
+            displaced.pos = from;
+            show(displaced, dirty);
+        }
+    }
+}
+
+void WindEffect::recolor(const std::vector<TreePart>& parts) {
+    for (Leaf& leaf : leaves_) {
+        if (leaf.part < parts.size()) {
+            leaf.glyph.colorIndex = parts[leaf.part].colorIndex;
+        }
+    }
+}
+
+void WindEffect::redraw(std::vector<TreePart>& dirty) const {
+    for (const Leaf& leaf : leaves_) {
+        if (occupant_[static_cast<std::size_t>(leaf.home)] == kEmpty) {
+            blank(leaf.home, dirty);
+        }
+        show(leaf, dirty);
+    }
+}
+
+void WindEffect::show(const Leaf& leaf, std::vector<TreePart>& dirty) const {
+    TreePart part = leaf.glyph;
+    part.y = leaf.pos / cols_;
+    part.x = leaf.pos % cols_;
+    dirty.push_back(part);
+}
+
+void WindEffect::blank(int cell, std::vector<TreePart>& dirty) const {
+    TreePart part;
+    part.y = cell / cols_;
+    part.x = cell % cols_;
+    part.colorIndex = -1;
+    dirty.push_back(part);
+}
+
+} // namespace hbonsai
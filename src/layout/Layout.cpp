@@ -0,0 +1,93 @@
+#include "hbonsai/layout.h"
+
+#include <algorithm>
+#include <cwchar>
+
+namespace hbonsai {
+namespace {
+
+int text_width(const wchar_t* text) {
+    int width = wcswidth(text, std::wcslen(text));
+    return width < 0 ? 0 : width;
+}
+
+// Lays out a single row of segments left to right, starting at column 0.
+void append_row(std::vector<BaseSegment>& segments, int row, std::initializer_list<BaseSegment> runs) {
+    int col = 0;
+    for (BaseSegment run : runs) {
+        run.row = row;
+        run.col = col;
+        col += text_width(run.text);
+        segments.push_back(run);
+    }
+}
+
+} // namespace
+
+std::pair<int, int> base_dimensions(int baseType) {
+    switch (baseType) {
+    case 1:
+        return {4, 31};
+    case 2:
+        return {3, 15};
+    default:
+        return {0, 0};
+    }
+}
+
+std::vector<BaseSegment> base_segments(const BonsaiConfig& config) {
+    std::vector<BaseSegment> segments;
+
+    if (config.baseType == 1) {
+        append_row(segments, 0, {
+            {0, 0, L":", kTextColor, true},
+            {0, 0, L"___________", config.colors[2], false},
+            {0, 0, L"./~~~\\.", config.colors[3], true},
+            {0, 0, L"___________", config.colors[2], false},
+            {0, 0, L":", kTextColor, false},
+        });
+        append_row(segments, 1, {{0, 0, L" \\                           / ", kTextColor, false}});
+        append_row(segments, 2, {{0, 0, L"  \\_________________________/ ", kTextColor, false}});
+        append_row(segments, 3, {{0, 0, L"  (_)                     (_)", kTextColor, false}});
+    } else if (config.baseType == 2) {
+        append_row(segments, 0, {
+            {0, 0, L"(", kTextColor, false},
+            {0, 0, L"---", config.colors[2], false},
+            {0, 0, L"./~~~\\.", config.colors[3], true},
+            {0, 0, L"---", config.colors[2], false},
+            {0, 0, L")", kTextColor, false},
+        });
+        append_row(segments, 1, {{0, 0, L" (           ) ", kTextColor, false}});
+        append_row(segments, 2, {{0, 0, L"  (_________)  ", kTextColor, false}});
+    }
+
+    return segments;
+}
+
+std::pair<int, int> base_origin(const BonsaiConfig& config, int rows, int cols) {
+    auto [height, width] = base_dimensions(config.baseType);
+    return {rows - height, std::max(0, (cols - width) / 2)};
+}
+
+std::pair<int, int> message_position(const BonsaiConfig& config, int rows, int cols) {
+    int msgY = std::clamp(static_cast<int>(rows * 0.7), 0, std::max(0, rows - 1));
+    int estimatedWidth = static_cast<int>(config.message.size());
+    int msgX = std::clamp(static_cast<int>(cols * 0.7), 0, std::max(0, cols - 1));
+    if (msgX + estimatedWidth >= cols) {
+        msgX = std::max(0, cols - estimatedWidth - 1);
+    }
+    return {msgY, msgX};
+}
+
+std::pair<int, int> title_position(const std::string& text, int rows, int cols) {
+    int x = cols - static_cast<int>(text.length());
+    x = x > 0 ? x / 2 : 0;
+
+    int y = 0;
+    if (rows > 0) {
+        y = std::min(rows - 1, std::max(1, rows / 6));
+    }
+    return {y, x};
+}
+
+} // namespace hbonsai
@@ -1,16 +1,34 @@
 #include <clocale>
 #include <iostream>
 #include <memory>
+#include "hbonsai/alloc_stats.h"
 #include "hbonsai/config.h"
 #include "hbonsai/bonsai_scene.h"
+#include "hbonsai/daemon.h"
 #include "hbonsai/renderer.h"
 #include "hbonsai/scenemanager.h"
+#include "hbonsai/survey.h"
+
+namespace {
+
+// Taken before printing, so the report's own allocations are left out.
+void report_allocations(const hbonsai::AppConfig& app) {
+    if (app.allocStats) {
+        hbonsai::print_alloc_stats(std::cerr, hbonsai::alloc_stats_report(), app.allocStatsJson);
+    }
+}
+
+} // namespace
 
 int main(int argc, char* argv[]) {
     std::setlocale(LC_ALL, "");
 
     // 1. Parse configuration from command line arguments
+    hbonsai::set_alloc_phase(hbonsai::AllocPhase::Config);
     hbonsai::Config config = hbonsai::parse_args(argc, argv);
+    if (!config.app.allocStats) {
+        hbonsai::stop_alloc_stats();
+    }
 
     if (config.exitRequested) {
         if (config.showHelp) {
@@ -19,18 +37,77 @@ int main(int argc, char* argv[]) {
         return config.exitCode;
     }
 
-    // 2. Initialize the renderer
-    hbonsai::Renderer renderer;
-    if (!renderer.isInitialized()) {
-        return 1; // Renderer failed to initialize
+    // Daemon, client, survey and seed search modes never touch the terminal library.
+    if (config.app.daemon) {
+        return hbonsai::run_daemon(config);
+    }
+    if (config.app.client) {
+        return hbonsai::run_client(config);
     }
+    if (config.app.survey > 0 || !config.app.findSeed.empty()) {
+        hbonsai::set_alloc_phase(hbonsai::AllocPhase::Generation);
+        int status = config.app.survey > 0 ? hbonsai::run_survey(config) : hbonsai::run_find_seed(config);
+        report_allocations(config.app);
+        return status;
+    }
+
+    hbonsai::BackendStats stats;
+    hbonsai::PaceStats paceStats;
+    hbonsai::GrowthStats growthStats;
+    {
+        // 2. Initialize the renderer
+        hbonsai::set_alloc_phase(hbonsai::AllocPhase::FirstFrame);
+        hbonsai::Renderer renderer(config.app);
+        if (!renderer.isInitialized()) {
+            return 1; // Renderer failed to initialize
+        }
+
+        hbonsai::SceneManager sceneManager;
+        sceneManager.addScene(std::make_unique<hbonsai::BonsaiScene>(config.app, config.bonsai, config.title,
+                                                                     &paceStats, &growthStats));
+
+        sceneManager.setFrameHook([](double) {
+            if (hbonsai::alloc_phase() == hbonsai::AllocPhase::FirstFrame) {
+                hbonsai::set_alloc_phase(hbonsai::AllocPhase::Frames);
+            }
+        });
 
-    hbonsai::SceneManager sceneManager;
-    sceneManager.addScene(std::make_unique<hbonsai::BonsaiScene>(config.app, config.bonsai, config.title));
+        sceneManager.run(renderer, config.app);
+        hbonsai::set_alloc_phase(hbonsai::AllocPhase::Exit);
+        // Queued frames refer to the scenes' trees, which go away with sceneManager.
+        renderer.flush();
 
-    sceneManager.run(renderer, config.app);
+        if (!sceneManager.quitByUser()) {
+            renderer.wait();
+        }
+        stats = renderer.stats();
+    }
 
-    renderer.wait();
+    // Reported once the terminal has been restored.
+    if (config.app.verbosity > 0) {
+        double perFrame = stats.frames > 0 ? static_cast<double>(stats.bytes) / static_cast<double>(stats.frames) : 0.0;
+        std::cerr << "backend: " << stats.name << (stats.capsCached ? " (cached capabilities)" : "") << ", startup "
+                  << stats.startupMs << " ms, first frame " << stats.firstFrameMs << " ms, " << stats.frames
+                  << " frames, " << stats.bytes << " bytes (" << perFrame << " bytes/frame), "
+                  << stats.framesMerged << " merged while the terminal was busy" << std::endl;
+        if (config.app.live && config.app.pace) {
+            std::cerr << "pacing: target " << paceStats.targetSeconds << " s, grown in " << paceStats.grownSeconds
+                      << " s over " << paceStats.frames << " frames (" << paceStats.partsPerFrame
+                      << " parts/frame), frame interval " << paceStats.intervalMs << " ms, terminal "
+                      << paceStats.renderMs << " ms and " << paceStats.bytesPerFrame << " bytes per frame"
+                      << std::endl;
+        }
+        if (growthStats.truncated > 0) {
+            std::cerr << "budgets: " << growthStats.truncated << " of " << growthStats.trees
+                      << " trees cut short, the last by the " << hbonsai::truncation_name(growthStats.lastTruncation)
+                      << " budget at " << growthStats.lastTruncatedParts << " parts" << std::endl;
+        }
+        if (stats.outputs > 1) {
+            std::cerr << "broadcast: " << stats.outputs << " outputs, " << stats.framesSkipped
+                      << " frames skipped by slow outputs, " << stats.keyframes << " keyframes" << std::endl;
+        }
+    }
+    report_allocations(config.app);
 
     return 0;
 }
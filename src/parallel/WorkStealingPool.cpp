@@ -0,0 +1,127 @@
+#include "hbonsai/thread_pool.h"
+
+#include <algorithm>
+
+namespace hbonsai {
+namespace {
+
+// Identifies the queue owned by the current thread, if it belongs to a pool.
+thread_local const WorkStealingPool* t_pool = nullptr;
+thread_local std::size_t t_queue = 0;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // The thread that calls wait() acts as the last worker.
+    for (unsigned i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 0; i + 1 < threads; ++i) {
+        threads_.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    std::size_t target = (t_pool == this) ? t_queue : nextQueue_++ % queues_.size();
+
+    // Count first so a thief can never observe a task it was not told about.
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    queued_.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    wake_.notify_one();
+    idle_.notify_one();
+}
+
+bool WorkStealingPool::runOne(std::size_t self) {
+    std::function<void()> task;
+
+    {
+        Queue& own = *queues_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+
+    for (std::size_t offset = 1; !task && offset < queues_.size(); ++offset) {
+        Queue& victim = *queues_[(self + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+
+    if (!task) {
+        return false;
+    }
+
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    task();
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        idle_.notify_all();
+    }
+    return true;
+}
+
+void WorkStealingPool::workerLoop(std::size_t index) {
+    t_pool = this;
+    t_queue = index;
+
+    while (true) {
+        if (runOne(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_acquire) > 0; });
+        if (stopping_) {
+            return;
+        }
+    }
+}
+
+void WorkStealingPool::wait() {
+    const WorkStealingPool* previousPool = t_pool;
+    std::size_t previousQueue = t_queue;
+    t_pool = this;
+    t_queue = queues_.size() - 1;
+
+    while (pending_.load(std::memory_order_acquire) > 0) {
+        if (runOne(t_queue)) {
+            continue;
+        }
+        // Everything left is running on other workers; sleep until it finishes
+        // or until one of them submits something we can help with.
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        idle_.wait(lock, [this] {
+            return pending_.load(std::memory_order_acquire) == 0 || queued_.load(std::memory_order_acquire) > 0;
+        });
+    }
+
+    t_pool = previousPool;
+    t_queue = previousQueue;
+}
+
+} // namespace hbonsai
@@ -0,0 +1,359 @@
+#include "hbonsai/ansi_backend.h"
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "hbonsai/utf8.h"
+
+namespace hbonsai {
+namespace {
+
+constexpr char kEnterScreen[] = "\033[?1049h\033[?25l\033[0m\033[2J";
+constexpr char kLeaveScreen[] = "\033[0m\033[?25h\033[?1049l";
+constexpr char kResetPalette[] = "\033]104\033\\";
+constexpr int kDefaultRows = 24;
+constexpr int kDefaultCols = 80;
+// How long a lone ESC waits for the rest of an escape sequence before it
+// counts as the Escape key. Arrow keys on a slow link can arrive in pieces.
+constexpr int kEscapeTimeoutMs = 100;
+
+// Terminal state for the fatal-signal handler, which cannot reach the backend.
+int g_signalFd = -1;
+struct termios g_signalTermios;
+volatile std::sig_atomic_t g_paletteChanged = 0;
+
+void restore_on_signal(int sig) {
+    if (g_signalFd >= 0) {
+        ssize_t ignored = write(g_signalFd, kLeaveScreen, sizeof(kLeaveScreen) - 1);
+        if (g_paletteChanged) {
+            ignored = write(g_signalFd, kResetPalette, sizeof(kResetPalette) - 1);
+        }
+        (void)ignored;
+        tcsetattr(g_signalFd, TCSANOW, &g_signalTermios);
+    }
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+}
+
+void set_signal_handlers(void (*handler)(int)) {
+    struct sigaction action {};
+    action.sa_handler = handler;
+    sigemptyset(&action.sa_mask);
+    for (int sig : {SIGINT, SIGTERM, SIGHUP, SIGQUIT}) {
+        sigaction(sig, &action, nullptr);
+    }
+}
+
+// Decodes one key from the front of buffer. Returns false if buffer holds no
+// complete key yet. With final, no more bytes are coming for an escape
+// sequence that is still incomplete: a lone ESC is the Escape key, anything
+// longer is dropped.
+bool decode_key(std::string& buffer, InputEvent& event, bool final) {
+    if (buffer.empty()) {
+        return false;
+    }
+
+    event = InputEvent{};
+    unsigned char lead = static_cast<unsigned char>(buffer[0]);
+    if (lead == 0x1b) {
+        if (buffer.size() == 1 && !final) {
+            return false;
+        }
+        if (buffer.size() == 1 || (buffer[1] != '[' && buffer[1] != 'O')) {
+            event.code = KeyCode::Escape;
+            buffer.erase(0, 1);
+            return true;
+        }
+
+        // CSI / SS3: parameters, then a final byte in 0x40-0x7e.
+        std::size_t end = 2;
+        while (end < buffer.size() && (buffer[end] < 0x40 || buffer[end] > 0x7e)) {
+            ++end;
+        }
+        if (end == buffer.size()) {
+            if (!final) {
+                return false;
+            }
+            event.code = KeyCode::Other;
+            buffer.clear();
+            return true;
+        }
+
+        std::string params = buffer.substr(2, end - 2);
+        switch (buffer[end]) {
+        case 'A':
+            event.code = KeyCode::Up;
+            break;
+        case 'B':
+            event.code = KeyCode::Down;
+            break;
+        case 'C':
+            event.code = KeyCode::Right;
+            break;
+        case 'D':
+            event.code = KeyCode::Left;
+            break;
+        case 'H':
+            event.code = KeyCode::Home;
+            break;
+        case 'F':
+            event.code = KeyCode::End;
+            break;
+        case '~':
+            if (params == "1" || params == "7") {
+                event.code = KeyCode::Home;
+            } else if (params == "4" || params == "8") {
+                event.code = KeyCode::End;
+            }
+            break;
+        default:
+            break;
+        }
+        buffer.erase(0, end + 1);
+        return true;
+    }
+
+    if (lead == '\r' || lead == '\n') {
+        event.code = KeyCode::Enter;
+        buffer.erase(0, 1);
+        return true;
+    }
+
+    std::size_t length = lead < 0x80 ? 1 : lead >= 0xf0 ? 4 : lead >= 0xe0 ? 3 : lead >= 0xc0 ? 2 : 1;
+    std::size_t valid = 1;
+    while (valid < length && valid < buffer.size() && (static_cast<unsigned char>(buffer[valid]) & 0xc0) == 0x80) {
+        ++valid;
+    }
+    if (valid < length) {
+        if (valid == buffer.size() && !final) {
+            return false; // the rest of the character may still be on its way
+        }
+        // A lead byte cut short by another character or by the timeout: drop
+        // it so that what follows is still read.
+        buffer.erase(0, valid);
+        event.code = KeyCode::Other;
+        return true;
+    }
+    std::wstring decoded = utf8_to_wstring(buffer.substr(0, length));
+    buffer.erase(0, length);
+    event.code = KeyCode::Character;
+    event.ch = decoded.empty() ? U'\0' : static_cast<char32_t>(decoded[0]);
+    return true;
+}
+
+} // namespace
+
+AnsiBackend::AnsiBackend() : front_(0, 0), back_(0, 0) {
+    auto start = std::chrono::steady_clock::now();
+
+    int fd = open("/dev/tty", O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Error: cannot open /dev/tty: " << std::strerror(errno) << std::endl;
+        return;
+    }
+    attach(fd, start);
+}
+
+AnsiBackend::AnsiBackend(int fd) : front_(0, 0), back_(0, 0) {
+    attach(fd, std::chrono::steady_clock::now());
+}
+
+void AnsiBackend::attach(int fd, std::chrono::steady_clock::time_point start) {
+    fd_ = fd;
+    if (tcgetattr(fd_, &savedTermios_) != 0) {
+        std::cerr << "Error: terminal output is not a tty." << std::endl;
+        close(fd_);
+        fd_ = -1;
+        return;
+    }
+
+    struct winsize size {};
+    int rows = kDefaultRows;
+    int cols = kDefaultCols;
+    if (ioctl(fd_, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0) {
+        rows = size.ws_row;
+        cols = size.ws_col;
+    }
+    front_ = AnsiCanvas(rows, cols);
+    back_ = AnsiCanvas(rows, cols);
+
+    struct termios raw = savedTermios_;
+    raw.c_lflag &= static_cast<tcflag_t>(~(ICANON | ECHO));
+    raw.c_iflag &= static_cast<tcflag_t>(~(IXON | ICRNL));
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(fd_, TCSANOW, &raw);
+
+    g_signalFd = fd_;
+    g_signalTermios = savedTermios_;
+    set_signal_handlers(restore_on_signal);
+
+    writeAll(kEnterScreen);
+    initialized_ = true;
+    startupMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+AnsiBackend::~AnsiBackend() {
+    if (!initialized_) {
+        return;
+    }
+    writeAll(kLeaveScreen);
+    if (paletteChanged_) {
+        writeAll(kResetPalette);
+    }
+    tcsetattr(fd_, TCSANOW, &savedTermios_);
+    set_signal_handlers(SIG_DFL);
+    g_signalFd = -1;
+    g_paletteChanged = 0;
+    close(fd_);
+}
+
+bool AnsiBackend::isInitialized() const {
+    return initialized_;
+}
+
+std::pair<int, int> AnsiBackend::dimensions() const {
+    return {back_.rows(), back_.cols()};
+}
+
+void AnsiBackend::prepareFrame(const BonsaiConfig& config) {
+    back_.clear();
+    compose_tree(back_, {}, config);
+}
+
+void AnsiBackend::drawStatic(const std::vector<TreePart>& parts, const BonsaiConfig& config) {
+    back_.clear();
+    compose_tree(back_, parts, config);
+}
+
+void AnsiBackend::drawLive(const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                           const BonsaiConfig& config) {
+    compose_parts(back_, parts, indices, config);
+}
+
+void AnsiBackend::drawCells(const std::vector<TreePart>& cells, const BonsaiConfig& config) {
+    compose_cells(back_, cells, config);
+}
+
+void AnsiBackend::renderTitle(const TitleConfig& config) {
+    compose_title(back_, config);
+}
+
+bool AnsiBackend::setPalette(const std::vector<PaletteEntry>& entries) {
+    if (!initialized_) {
+        return false;
+    }
+
+    // OSC 4; sent with the next frame so colour and content change together.
+    for (const auto& entry : entries) {
+        append_palette(palette_, entry.index, entry.rgb);
+    }
+    paletteChanged_ = true;
+    g_paletteChanged = 1;
+    return true;
+}
+
+bool AnsiBackend::canSetPalette() const {
+    return initialized_;
+}
+
+void AnsiBackend::render() {
+    if (!initialized_) {
+        return;
+    }
+
+    out_.swap(palette_);
+    palette_.clear();
+    back_.encodeDiff(front_, out_);
+    if (out_.empty()) {
+        return;
+    }
+    writeAll(out_);
+    ++frames_;
+    front_ = back_;
+}
+
+void AnsiBackend::writeAll(const std::string& data) {
+    std::size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t written = write(fd_, data.data() + offset, data.size() - offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        offset += static_cast<std::size_t>(written);
+    }
+    bytes_ += static_cast<long long>(data.size());
+}
+
+bool AnsiBackend::readInput(int timeoutMs) {
+    struct pollfd pfd {fd_, POLLIN, 0};
+    if (poll(&pfd, 1, timeoutMs) <= 0 || !(pfd.revents & POLLIN)) {
+        return false;
+    }
+
+    char buffer[64];
+    ssize_t count = read(fd_, buffer, sizeof(buffer));
+    if (count <= 0) {
+        return false;
+    }
+    input_.append(buffer, static_cast<std::size_t>(count));
+    return true;
+}
+
+void AnsiBackend::wait() {
+    if (!initialized_) {
+        return;
+    }
+
+    InputEvent event;
+    readKey(event, -1);
+}
+
+bool AnsiBackend::pollInput(InputEvent& event) {
+    if (!initialized_) {
+        return false;
+    }
+
+    return readKey(event, 0);
+}
+
+bool AnsiBackend::readKey(InputEvent& event, int timeoutMs) {
+    while (!decode_key(input_, event, false)) {
+        if (input_.empty()) {
+            if (!readInput(timeoutMs)) {
+                return false;
+            }
+        } else if (!readInput(kEscapeTimeoutMs)) {
+            // The rest of the sequence did not come: take it as it stands.
+            return decode_key(input_, event, true);
+        }
+    }
+    return true;
+}
+
+int AnsiBackend::inputFd() const {
+    // Bytes already buffered are not visible to poll(); report no descriptor so
+    // the frame loop does not sleep on them.
+    return input_.empty() ? fd_ : -1;
+}
+
+BackendStats AnsiBackend::stats() const {
+    BackendStats result;
+    result.name = "ansi";
+    result.startupMs = startupMs_;
+    result.frames = frames_;
+    result.bytes = bytes_;
+    return result;
+}
+
+} // namespace hbonsai
@@ -0,0 +1,373 @@
+#include "hbonsai/broadcast_backend.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace hbonsai {
+namespace {
+
+constexpr char kEnterScreen[] = "\033[?1049h\033[?25l\033[0m\033[2J";
+constexpr char kLeaveScreen[] = "\033[0m\033[?25h\033[?1049l";
+constexpr char kResetPalette[] = "\033]104\033\\";
+constexpr char kClearScreen[] = "\033[0m\033[2J";
+constexpr int kDefaultRows = 24;
+constexpr int kDefaultCols = 80;
+constexpr int kPaletteSize = 256;
+constexpr int kExitFlushMs = 200; // how long the destructor waits for slow outputs
+
+// Output descriptors for the fatal-signal handler, which cannot reach the backend.
+constexpr std::size_t kMaxSignalFds = 256;
+int g_signalFds[kMaxSignalFds];
+volatile std::sig_atomic_t g_signalCount = 0;
+volatile std::sig_atomic_t g_paletteChanged = 0;
+
+void restore_on_signal(int sig) {
+    for (std::sig_atomic_t i = 0; i < g_signalCount; ++i) {
+        ssize_t ignored = write(g_signalFds[i], kLeaveScreen, sizeof(kLeaveScreen) - 1);
+        if (g_paletteChanged) {
+            ignored = write(g_signalFds[i], kResetPalette, sizeof(kResetPalette) - 1);
+        }
+        (void)ignored;
+    }
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+}
+
+void set_signal_handlers(void (*handler)(int)) {
+    struct sigaction action {};
+    action.sa_handler = handler;
+    sigemptyset(&action.sa_mask);
+    for (int sig : {SIGINT, SIGTERM, SIGHUP, SIGQUIT}) {
+        sigaction(sig, &action, nullptr);
+    }
+}
+
+} // namespace
+
+BroadcastBackend::BroadcastBackend(const std::vector<std::string>& paths) : front_(0, 0), back_(0, 0) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<int> fds;
+    for (const std::string& path : paths) {
+        int fd = open(path.c_str(), O_WRONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            std::cerr << "error: cannot open broadcast output " << path << ": " << std::strerror(errno) << std::endl;
+            for (int opened : fds) {
+                close(opened);
+            }
+            return;
+        }
+        fds.push_back(fd);
+    }
+    attach(fds);
+    startupMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+BroadcastBackend::BroadcastBackend(const std::vector<int>& fds) : front_(0, 0), back_(0, 0) {
+    auto start = std::chrono::steady_clock::now();
+    for (int fd : fds) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+    attach(fds);
+    startupMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BroadcastBackend::attach(const std::vector<int>& fds) {
+    if (fds.empty()) {
+        std::cerr << "error: no broadcast outputs" << std::endl;
+        return;
+    }
+
+    // One canvas for everybody, so it has to fit the smallest terminal.
+    int rows = 0;
+    int cols = 0;
+    for (int fd : fds) {
+        struct winsize size {};
+        int outRows = kDefaultRows;
+        int outCols = kDefaultCols;
+        if (ioctl(fd, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0) {
+            outRows = size.ws_row;
+            outCols = size.ws_col;
+        }
+        rows = rows == 0 ? outRows : std::min(rows, outRows);
+        cols = cols == 0 ? outCols : std::min(cols, outCols);
+
+        Output out;
+        out.fd = fd;
+        outputs_.push_back(out);
+    }
+    front_ = AnsiCanvas(rows, cols);
+    back_ = AnsiCanvas(rows, cols);
+    rgb_.assign(kPaletteSize, -1);
+
+    g_signalCount = 0;
+    for (std::size_t i = 0; i < outputs_.size() && i < kMaxSignalFds; ++i) {
+        g_signalFds[i] = outputs_[i].fd;
+        g_signalCount = static_cast<std::sig_atomic_t>(i + 1);
+    }
+    set_signal_handlers(restore_on_signal);
+    // An output whose reader went away must not kill the others.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    Frame enter = std::make_shared<const std::string>(kEnterScreen);
+    for (Output& out : outputs_) {
+        out.pending = enter;
+        flush(out);
+    }
+    initialized_ = true;
+}
+
+BroadcastBackend::~BroadcastBackend() {
+    if (outputs_.empty()) {
+        return;
+    }
+
+    // Give outputs a moment to take the last frame and the leave sequence,
+    // but never hang on one that stopped reading.
+    auto drain = [this] {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kExitFlushMs);
+        while (std::chrono::steady_clock::now() < deadline && flushPending(10)) {
+        }
+    };
+    drain();
+
+    bool paletteChanged = std::any_of(rgb_.begin(), rgb_.end(), [](std::int64_t rgb) { return rgb >= 0; });
+    std::string leave = std::string(kLeaveScreen) + (paletteChanged ? kResetPalette : "");
+    Frame leaveFrame = std::make_shared<const std::string>(leave);
+    for (Output& out : outputs_) {
+        if (out.fd < 0) {
+            continue;
+        }
+        if (out.pending) {
+            // Behind the rest of the frame: sent ahead of it, the reset would
+            // end up inside one of the frame's escape sequences.
+            out.pending = std::make_shared<const std::string>(out.pending->substr(out.offset) + leave);
+        } else {
+            out.pending = leaveFrame;
+        }
+        out.offset = 0;
+        flush(out);
+    }
+    drain();
+    for (Output& out : outputs_) {
+        if (out.fd >= 0) {
+            close(out.fd);
+        }
+    }
+    set_signal_handlers(SIG_DFL);
+    g_signalCount = 0;
+    g_paletteChanged = 0;
+}
+
+bool BroadcastBackend::isInitialized() const {
+    return initialized_;
+}
+
+std::pair<int, int> BroadcastBackend::dimensions() const {
+    return {back_.rows(), back_.cols()};
+}
+
+void BroadcastBackend::prepareFrame(const BonsaiConfig& config) {
+    back_.clear();
+    compose_tree(back_, {}, config);
+}
+
+void BroadcastBackend::drawStatic(const std::vector<TreePart>& parts, const BonsaiConfig& config) {
+    back_.clear();
+    compose_tree(back_, parts, config);
+}
+
+void BroadcastBackend::drawLive(const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                                const BonsaiConfig& config) {
+    compose_parts(back_, parts, indices, config);
+}
+
+void BroadcastBackend::drawCells(const std::vector<TreePart>& cells, const BonsaiConfig& config) {
+    compose_cells(back_, cells, config);
+}
+
+void BroadcastBackend::renderTitle(const TitleConfig& config) {
+    compose_title(back_, config);
+}
+
+bool BroadcastBackend::setPalette(const std::vector<PaletteEntry>& entries) {
+    if (!initialized_) {
+        return false;
+    }
+
+    for (const auto& entry : entries) {
+        if (entry.index < 0 || entry.index >= kPaletteSize) {
+            continue;
+        }
+        append_palette(palette_, entry.index, entry.rgb);
+        rgb_[static_cast<std::size_t>(entry.index)] = entry.rgb;
+    }
+    g_paletteChanged = 1;
+    return true;
+}
+
+bool BroadcastBackend::canSetPalette() const {
+    return initialized_;
+}
+
+void BroadcastBackend::render() {
+    if (!initialized_) {
+        return;
+    }
+
+    // Encoded once, whatever the number of outputs.
+    std::string diff;
+    diff.swap(palette_);
+    back_.encodeDiff(front_, diff);
+    Frame frame;
+    if (!diff.empty()) {
+        frame = std::make_shared<const std::string>(std::move(diff));
+        front_ = back_;
+        keyframe_.reset();
+        ++frames_;
+    }
+
+    for (Output& out : outputs_) {
+        if (out.fd < 0) {
+            continue;
+        }
+        flush(out);
+        if (out.pending) {
+            // Still on an earlier frame: this one is dropped, and the output
+            // skips straight to the latest canvas once it catches up.
+            if (frame) {
+                out.stale = true;
+                ++out.skipped;
+            }
+            continue;
+        }
+        if (out.stale) {
+            sendKeyframe(out);
+        } else if (frame) {
+            out.pending = frame;
+        } else {
+            continue;
+        }
+        out.offset = 0;
+        flush(out);
+    }
+}
+
+const BroadcastBackend::Frame& BroadcastBackend::keyframe() {
+    if (!keyframe_) {
+        std::string data = kClearScreen;
+        for (int index = 0; index < kPaletteSize; ++index) {
+            std::int64_t rgb = rgb_[static_cast<std::size_t>(index)];
+            if (rgb >= 0) {
+                append_palette(data, index, static_cast<std::uint32_t>(rgb));
+            }
+        }
+        front_.encodeDiff(AnsiCanvas(front_.rows(), front_.cols()), data);
+        keyframe_ = std::make_shared<const std::string>(std::move(data));
+    }
+    return keyframe_;
+}
+
+void BroadcastBackend::sendKeyframe(Output& out) {
+    out.pending = keyframe();
+    out.offset = 0;
+    out.stale = false;
+    ++out.keyframes;
+}
+
+void BroadcastBackend::flush(Output& out) {
+    while (out.fd >= 0 && out.pending) {
+        const std::string& data = *out.pending;
+        ssize_t written = write(out.fd, data.data() + out.offset, data.size() - out.offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // Hung up or gone; the remaining outputs carry on.
+                close(out.fd);
+                out.fd = -1;
+                out.pending.reset();
+            }
+            return;
+        }
+        out.bytes += written;
+        out.offset += static_cast<std::size_t>(written);
+        if (out.offset == data.size()) {
+            out.pending.reset();
+            out.offset = 0;
+        }
+    }
+}
+
+void BroadcastBackend::wait() {
+    if (!initialized_) {
+        return;
+    }
+
+    // No more render() calls will come to catch up outputs that dropped
+    // frames, so they get the finished canvas here.
+    do {
+        for (Output& out : outputs_) {
+            if (out.fd >= 0 && !out.pending && out.stale) {
+                sendKeyframe(out);
+                flush(out);
+            }
+        }
+    } while (flushPending(-1));
+
+    // The finished tree stays up until hbonsai is told to stop.
+    while (true) {
+        pause();
+    }
+}
+
+bool BroadcastBackend::flushPending(int timeoutMs) {
+    std::vector<struct pollfd> waiting;
+    for (const Output& out : outputs_) {
+        if (out.fd >= 0 && out.pending) {
+            waiting.push_back({out.fd, POLLOUT, 0});
+        }
+    }
+    if (waiting.empty()) {
+        return false;
+    }
+    poll(waiting.data(), waiting.size(), timeoutMs);
+    for (Output& out : outputs_) {
+        flush(out);
+    }
+    return true;
+}
+
+bool BroadcastBackend::pollInput(InputEvent& event) {
+    (void)event;
+    return false;
+}
+
+int BroadcastBackend::inputFd() const {
+    return -1;
+}
+
+BackendStats BroadcastBackend::stats() const {
+    BackendStats result;
+    result.name = "broadcast";
+    result.startupMs = startupMs_;
+    result.frames = frames_;
+    for (const Output& out : outputs_) {
+        result.bytes += out.bytes;
+        result.framesSkipped += out.skipped;
+        result.keyframes += out.keyframes;
+    }
+    result.outputs = static_cast<int>(outputs_.size());
+    return result;
+}
+
+} // namespace hbonsai
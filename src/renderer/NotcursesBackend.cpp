@@ -0,0 +1,322 @@
+#include "hbonsai/notcurses_backend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cwchar>
+#include <iostream>
+#include <notcurses/notcurses.h>
+#include <string>
+
+#include "hbonsai/layout.h"
+#include "hbonsai/title.h"
+
+namespace hbonsai {
+
+NotcursesBackend::NotcursesBackend(std::FILE* out) {
+    auto start = std::chrono::steady_clock::now();
+    struct notcurses_options ncopts = {
+        .flags = NCOPTION_SUPPRESS_BANNERS
+    };
+
+    nc_ = notcurses_init(&ncopts, out);
+    if (nc_ == nullptr) {
+        std::cerr << "Error: notcurses_init() failed." << std::endl;
+        return;
+    }
+
+    stdplane_ = notcurses_stdplane(nc_);
+    initialized_ = true;
+    startupMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+NotcursesBackend::~NotcursesBackend() {
+    if (palette_ != nullptr) {
+        ncpalette_free(palette_);
+    }
+    if (initialized_) {
+        notcurses_stop(nc_);
+    }
+}
+
+bool NotcursesBackend::isInitialized() const {
+    return initialized_;
+}
+
+std::pair<int, int> NotcursesBackend::dimensions() const {
+    if (!initialized_) {
+        return {0, 0};
+    }
+    unsigned rows = 0;
+    unsigned cols = 0;
+    ncplane_dim_yx(stdplane_, &rows, &cols);
+    return {static_cast<int>(rows), static_cast<int>(cols)};
+}
+
+void NotcursesBackend::setPlaneColor(int colorIndex, bool bold) {
+    uint64_t channels = 0;
+    if (colorIndex >= 0) {
+        ncchannels_set_fg_palindex(&channels, colorIndex);
+    } else {
+        ncchannels_set_fg_default(&channels);
+    }
+    ncchannels_set_bg_default(&channels);
+    ncplane_set_channels(stdplane_, channels);
+    ncplane_set_styles(stdplane_, bold ? NCSTYLE_BOLD : NCSTYLE_NONE);
+}
+
+void NotcursesBackend::prepareFrame(const BonsaiConfig& config) {
+    if (!initialized_) {
+        return;
+    }
+
+    ncplane_erase(stdplane_);
+    unsigned rows = 0;
+    unsigned cols = 0;
+    ncplane_dim_yx(stdplane_, &rows, &cols);
+
+    drawBase(config, static_cast<int>(rows), static_cast<int>(cols));
+    drawMessage(config, static_cast<int>(rows), static_cast<int>(cols));
+}
+
+void NotcursesBackend::drawStatic(const std::vector<TreePart>& parts, const BonsaiConfig& config) {
+    if (!initialized_) {
+        return;
+    }
+
+    prepareFrame(config);
+
+    unsigned rows = 0;
+    unsigned cols = 0;
+    ncplane_dim_yx(stdplane_, &rows, &cols);
+
+    drawTree(parts, config, static_cast<int>(rows), static_cast<int>(cols));
+    drawMessage(config, static_cast<int>(rows), static_cast<int>(cols));
+}
+
+void NotcursesBackend::drawLive(const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                                const BonsaiConfig& config) {
+    if (!initialized_ || indices.empty()) {
+        return;
+    }
+
+    unsigned rows = 0;
+    unsigned cols = 0;
+    ncplane_dim_yx(stdplane_, &rows, &cols);
+
+    int treeHeight = static_cast<int>(rows) - base_dimensions(config.baseType).first;
+    for (std::size_t index : indices) {
+        if (index >= parts.size()) {
+            continue;
+        }
+        const TreePart& part = parts[index];
+        if (part.y < 0 || part.y >= treeHeight || part.x < 0 || part.x >= static_cast<int>(cols)) {
+            continue;
+        }
+        drawPart(part);
+    }
+
+    drawMessage(config, static_cast<int>(rows), static_cast<int>(cols));
+}
+
+void NotcursesBackend::drawCells(const std::vector<TreePart>& cells, const BonsaiConfig& config) {
+    if (!initialized_ || cells.empty()) {
+        return;
+    }
+
+    unsigned rows = 0;
+    unsigned cols = 0;
+    ncplane_dim_yx(stdplane_, &rows, &cols);
+
+    int treeHeight = static_cast<int>(rows) - base_dimensions(config.baseType).first;
+    for (const TreePart& cell : cells) {
+        if (cell.y < 0 || cell.y >= treeHeight || cell.x < 0 || cell.x >= static_cast<int>(cols)) {
+            continue;
+        }
+        drawPart(cell);
+    }
+
+    drawMessage(config, static_cast<int>(rows), static_cast<int>(cols));
+}
+
+void NotcursesBackend::render() {
+    if (!initialized_) {
+        return;
+    }
+
+    ncplane_set_styles(stdplane_, NCSTYLE_NONE);
+    notcurses_render(nc_);
+}
+
+void NotcursesBackend::drawPart(const TreePart& part) {
+    setPlaneColor(part.colorIndex, part.bold);
+    if (part.egc) {
+        ncplane_putegc_yx(stdplane_, part.y, part.x, part.egc, nullptr);
+    } else {
+        ncplane_putwc_yx(stdplane_, part.y, part.x, part.ch);
+    }
+}
+
+void NotcursesBackend::drawTree(const std::vector<TreePart>& parts, const BonsaiConfig& config, int rows, int cols) {
+    int baseHeight = base_dimensions(config.baseType).first;
+    int treeHeight = rows - baseHeight;
+    if (treeHeight <= 0) {
+        return;
+    }
+
+    for (const auto& part : parts) {
+        int y = part.y;
+        int x = part.x;
+        if (y < 0 || y >= treeHeight || x < 0 || x >= cols) {
+            continue;
+        }
+
+        drawPart(part);
+    }
+}
+
+void NotcursesBackend::drawBase(const BonsaiConfig& config, int rows, int cols) {
+    auto [height, width] = base_dimensions(config.baseType);
+    if (height == 0 || width == 0) {
+        return;
+    }
+
+    auto [startY, startX] = base_origin(config, rows, cols);
+    for (const auto& segment : base_segments(config)) {
+        setPlaneColor(segment.colorIndex, segment.bold);
+        ncplane_putwstr_yx(stdplane_, startY + segment.row, startX + segment.col, segment.text);
+    }
+}
+
+void NotcursesBackend::drawMessage(const BonsaiConfig& config, int rows, int cols) {
+    if (config.message.empty()) {
+        return;
+    }
+
+    auto [msgY, msgX] = message_position(config, rows, cols);
+    setPlaneColor(kTextColor, true);
+    ncplane_putstr_yx(stdplane_, msgY, msgX, config.message.c_str());
+}
+
+bool NotcursesBackend::setPalette(const std::vector<PaletteEntry>& entries) {
+    if (!initialized_ || !notcurses_canchangecolor(nc_)) {
+        return false;
+    }
+    if (palette_ == nullptr) {
+        palette_ = ncpalette_new(nc_);
+        if (palette_ == nullptr) {
+            return false;
+        }
+    }
+    for (const auto& entry : entries) {
+        ncpalette_set(palette_, entry.index, entry.rgb);
+    }
+    return ncpalette_use(nc_, palette_) == 0;
+}
+
+bool NotcursesBackend::canSetPalette() const {
+    return initialized_ && notcurses_canchangecolor(nc_);
+}
+
+void NotcursesBackend::renderTitle(const TitleConfig& config) {
+    if (!initialized_ || config.text.empty()) {
+        return;
+    }
+
+    setPlaneColor(kTextColor, true);
+    Title title(config.text);
+    title.render(stdplane_);
+    ncplane_set_styles(stdplane_, NCSTYLE_NONE);
+}
+
+void NotcursesBackend::wait() {
+    notcurses_get_blocking(nc_, nullptr);
+}
+
+bool NotcursesBackend::pollInput(InputEvent& event) {
+    if (!initialized_) {
+        return false;
+    }
+
+    ncinput input{};
+    uint32_t id = notcurses_get_nblock(nc_, &input);
+    if (id == 0 || id == static_cast<uint32_t>(-1)) {
+        return false;
+    }
+    if (input.evtype == NCTYPE_RELEASE) {
+        return pollInput(event);
+    }
+
+    event = InputEvent{};
+    switch (id) {
+    case NCKEY_RESIZE:
+        // Not a key press; nothing to report.
+        return pollInput(event);
+    case NCKEY_LEFT:
+        event.code = KeyCode::Left;
+        break;
+    case NCKEY_RIGHT:
+        event.code = KeyCode::Right;
+        break;
+    case NCKEY_UP:
+        event.code = KeyCode::Up;
+        break;
+    case NCKEY_DOWN:
+        event.code = KeyCode::Down;
+        break;
+    case NCKEY_HOME:
+        event.code = KeyCode::Home;
+        break;
+    case NCKEY_END:
+        event.code = KeyCode::End;
+        break;
+    case NCKEY_ENTER:
+        event.code = KeyCode::Enter;
+        break;
+    case NCKEY_ESC:
+        event.code = KeyCode::Escape;
+        break;
+    default:
+        if (id < 0x110000u) {
+            event.code = KeyCode::Character;
+            event.ch = static_cast<char32_t>(id);
+        }
+        break;
+    }
+    return true;
+}
+
+int NotcursesBackend::inputFd() const {
+    return initialized_ ? notcurses_inputready_fd(nc_) : -1;
+}
+
+BackendStats NotcursesBackend::stats() const {
+    BackendStats result;
+    result.name = "notcurses";
+    result.startupMs = startupMs_;
+    if (initialized_) {
+        ncstats stats{};
+        notcurses_stats(nc_, &stats);
+        result.frames = static_cast<long long>(stats.writeouts);
+        result.bytes = static_cast<long long>(stats.raster_bytes);
+    }
+    return result;
+}
+
+TerminalCaps NotcursesBackend::capabilities() const {
+    TerminalCaps caps;
+    if (!initialized_) {
+        return caps;
+    }
+
+    caps.utf8 = notcurses_canutf8(nc_);
+    caps.paletteSize = notcurses_palette_size(nc_);
+    caps.truecolor = notcurses_cantruecolor(nc_);
+    if (char* name = notcurses_detected_terminal(nc_)) {
+        caps.name = name;
+        free(name);
+    }
+    return caps;
+}
+
+} // namespace hbonsai
@@ -0,0 +1,65 @@
+#include "hbonsai/null_backend.h"
+
+namespace hbonsai {
+
+void NullBackend::prepareFrame(const BonsaiConfig& config) {
+    (void)config;
+    ++calls_.prepareFrame;
+}
+
+void NullBackend::drawStatic(const std::vector<TreePart>& parts, const BonsaiConfig& config) {
+    (void)config;
+    ++calls_.drawStatic;
+    calls_.partsDrawn += static_cast<long long>(parts.size());
+}
+
+void NullBackend::drawLive(const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                           const BonsaiConfig& config) {
+    (void)parts;
+    (void)config;
+    ++calls_.drawLive;
+    calls_.partsDrawn += static_cast<long long>(indices.size());
+}
+
+void NullBackend::drawCells(const std::vector<TreePart>& cells, const BonsaiConfig& config) {
+    (void)config;
+    ++calls_.drawCells;
+    calls_.cellsDrawn += static_cast<long long>(cells.size());
+}
+
+void NullBackend::renderTitle(const TitleConfig& config) {
+    (void)config;
+    ++calls_.renderTitle;
+}
+
+bool NullBackend::setPalette(const std::vector<PaletteEntry>& entries) {
+    (void)entries;
+    ++calls_.setPalette;
+    return true;
+}
+
+void NullBackend::render() {
+    ++calls_.render;
+}
+
+void NullBackend::wait() {
+    ++calls_.wait;
+}
+
+bool NullBackend::pollInput(InputEvent& event) {
+    if (input_.empty()) {
+        return false;
+    }
+    event = input_.front();
+    input_.pop_front();
+    return true;
+}
+
+BackendStats NullBackend::stats() const {
+    BackendStats result;
+    result.name = "null";
+    result.frames = calls_.render;
+    return result;
+}
+
+} // namespace hbonsai
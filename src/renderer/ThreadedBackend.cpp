@@ -0,0 +1,367 @@
+#include "hbonsai/threaded_backend.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace hbonsai {
+namespace {
+
+constexpr double kCostSmoothing = 0.2; // weight of the newest frame in cost_
+
+} // namespace
+
+ThreadedBackend::ThreadedBackend(std::unique_ptr<RenderBackend> backend) : backend_(std::move(backend)) {
+    // Everything the caller's thread may ask later is read now, before the
+    // writer starts using the backend.
+    initialized_ = backend_->isInitialized();
+    canSetPalette_ = backend_->canSetPalette();
+    dimensions_ = backend_->dimensions();
+    if (initialized_) {
+        writer_ = std::thread([this] { run(); });
+    }
+}
+
+ThreadedBackend::~ThreadedBackend() {
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+    }
+}
+
+bool ThreadedBackend::isInitialized() const {
+    return initialized_;
+}
+
+std::pair<int, int> ThreadedBackend::dimensions() const {
+    return dimensions_;
+}
+
+void ThreadedBackend::prepareFrame(const BonsaiConfig& config) {
+    Command command;
+    command.kind = Command::Kind::Prepare;
+    command.config = &config;
+    building_.push_back(std::move(command));
+}
+
+void ThreadedBackend::drawStatic(const std::vector<TreePart>& parts, const BonsaiConfig& config) {
+    Command command;
+    command.kind = Command::Kind::Static;
+    command.config = &config;
+    command.parts = parts;
+    building_.push_back(std::move(command));
+}
+
+void ThreadedBackend::drawLive(const std::vector<TreePart>& parts, const std::vector<std::size_t>& indices,
+                               const BonsaiConfig& config) {
+    if (indices.empty()) {
+        return;
+    }
+    // The scene may replace parts before the writer gets to them, so only the
+    // drawn ones are copied; every backend clips them the same way as cells.
+    Command command;
+    command.kind = Command::Kind::Cells;
+    command.config = &config;
+    command.parts.reserve(indices.size());
+    for (std::size_t index : indices) {
+        if (index < parts.size()) {
+            command.parts.push_back(parts[index]);
+        }
+    }
+    building_.push_back(std::move(command));
+}
+
+void ThreadedBackend::drawCells(const std::vector<TreePart>& cells, const BonsaiConfig& config) {
+    if (cells.empty()) {
+        return;
+    }
+    Command command;
+    command.kind = Command::Kind::Cells;
+    command.config = &config;
+    command.parts = cells;
+    building_.push_back(std::move(command));
+}
+
+void ThreadedBackend::renderTitle(const TitleConfig& config) {
+    Command command;
+    command.kind = Command::Kind::Title;
+    command.title = config;
+    building_.push_back(std::move(command));
+}
+
+bool ThreadedBackend::setPalette(const std::vector<PaletteEntry>& entries) {
+    if (!canSetPalette_) {
+        return false;
+    }
+    Command command;
+    command.kind = Command::Kind::Palette;
+    command.palette = entries;
+    building_.push_back(std::move(command));
+    return true;
+}
+
+bool ThreadedBackend::canSetPalette() const {
+    return canSetPalette_;
+}
+
+void ThreadedBackend::render() {
+    if (!initialized_) {
+        building_.clear();
+        return;
+    }
+    // Nothing drawn: the terminal already shows this frame.
+    if (building_.empty() && handedOver_ > 0) {
+        return;
+    }
+
+    bool first = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (full_) {
+            merge(mailbox_, std::move(building_), dimensions_);
+            ++merged_;
+        } else {
+            mailbox_ = std::move(building_);
+            full_ = true;
+        }
+        first = handedOver_++ == 0;
+    }
+    building_.clear();
+    wake_.notify_one();
+
+    // The first frame is waited for, so startup timings still mean time on
+    // screen.
+    if (first) {
+        waitIdle();
+    }
+}
+
+void ThreadedBackend::merge(Frame& waiting, Frame&& newer, std::pair<int, int> dimensions) {
+    // Drawing before a clear is invisible; palette changes are terminal state
+    // and always survive.
+    auto clears = [](const Command& command) {
+        return command.kind == Command::Kind::Prepare || command.kind == Command::Kind::Static;
+    };
+    if (std::any_of(newer.begin(), newer.end(), clears)) {
+        waiting.erase(std::remove_if(waiting.begin(), waiting.end(),
+                                     [](const Command& command) { return command.kind != Command::Kind::Palette; }),
+                      waiting.end());
+    }
+    waiting.insert(waiting.end(), std::make_move_iterator(newer.begin()), std::make_move_iterator(newer.end()));
+
+    // Effects keep drawing after the tree is done, with no clear in sight;
+    // past a screenful of cells, fold the frame down to what it shows.
+    auto [rows, cols] = dimensions;
+    std::size_t cells = 0;
+    for (const Command& command : waiting) {
+        if (command.kind == Command::Kind::Cells) {
+            cells += command.parts.size();
+        }
+    }
+    if (cells > static_cast<std::size_t>(std::max(rows, 1)) * static_cast<std::size_t>(std::max(cols, 1))) {
+        compact(waiting, rows, cols);
+    }
+}
+
+void ThreadedBackend::compact(Frame& frame, int rows, int cols) {
+    // Palette changes commute with drawing, and only the last colour of each
+    // slot counts. Drawing before the last clear is invisible. Every title
+    // has the same text, so only the last one matters: cells before it stay
+    // under it, cells after it go on top, and of the cells drawn at one
+    // position only the last is kept, in the order the survivors were drawn.
+    std::vector<PaletteEntry> palette;
+    std::vector<int> slot(256, -1);
+    std::size_t base = 0;
+    bool hasClear = false;
+    std::size_t lastTitle = frame.size();
+    const BonsaiConfig* config = nullptr;
+    for (std::size_t i = 0; i < frame.size(); ++i) {
+        const Command& command = frame[i];
+        switch (command.kind) {
+        case Command::Kind::Palette:
+            for (const PaletteEntry& entry : command.palette) {
+                if (entry.index < 0 || entry.index >= 256) {
+                    continue;
+                }
+                int& at = slot[static_cast<std::size_t>(entry.index)];
+                if (at < 0) {
+                    at = static_cast<int>(palette.size());
+                    palette.push_back(entry);
+                } else {
+                    palette[static_cast<std::size_t>(at)] = entry;
+                }
+            }
+            break;
+        case Command::Kind::Prepare:
+        case Command::Kind::Static:
+            base = i;
+            hasClear = true;
+            lastTitle = frame.size();
+            break;
+        case Command::Kind::Title:
+            lastTitle = i;
+            break;
+        case Command::Kind::Cells:
+            config = command.config;
+            break;
+        }
+    }
+
+    std::vector<bool> seen(static_cast<std::size_t>(rows) * static_cast<std::size_t>(cols));
+    auto collect = [&](std::size_t begin, std::size_t end) {
+        std::fill(seen.begin(), seen.end(), false);
+        Command cells;
+        cells.kind = Command::Kind::Cells;
+        cells.config = config;
+        for (std::size_t i = end; i-- > begin;) {
+            if (frame[i].kind != Command::Kind::Cells) {
+                continue;
+            }
+            const std::vector<TreePart>& parts = frame[i].parts;
+            for (std::size_t j = parts.size(); j-- > 0;) {
+                const TreePart& part = parts[j];
+                if (part.y < 0 || part.y >= rows || part.x < 0 || part.x >= cols) {
+                    continue;
+                }
+                std::size_t at = static_cast<std::size_t>(part.y) * static_cast<std::size_t>(cols) +
+                                 static_cast<std::size_t>(part.x);
+                if (!seen[at]) {
+                    seen[at] = true;
+                    cells.parts.push_back(part);
+                }
+            }
+        }
+        std::reverse(cells.parts.begin(), cells.parts.end());
+        return cells;
+    };
+
+    Frame compacted;
+    if (!palette.empty()) {
+        Command command;
+        command.kind = Command::Kind::Palette;
+        command.palette = std::move(palette);
+        compacted.push_back(std::move(command));
+    }
+    std::size_t begin = base;
+    if (hasClear) {
+        compacted.push_back(std::move(frame[base]));
+        ++begin;
+    }
+    std::size_t split = std::min(lastTitle, frame.size());
+    Command before = collect(begin, split);
+    if (!before.parts.empty()) {
+        compacted.push_back(std::move(before));
+    }
+    if (split < frame.size()) {
+        Command after = collect(split + 1, frame.size());
+        compacted.push_back(std::move(frame[split]));
+        if (!after.parts.empty()) {
+            compacted.push_back(std::move(after));
+        }
+    }
+    frame = std::move(compacted);
+}
+
+void ThreadedBackend::run() {
+    Frame frame;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return full_ || stop_; });
+            if (!full_) {
+                return;
+            }
+            frame.swap(mailbox_);
+            mailbox_.clear();
+            full_ = false;
+            busy_ = true;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        long long bytesBefore = backend_->stats().bytes;
+        replay(frame);
+        backend_->render();
+        frame.clear();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double bytes = static_cast<double>(backend_->stats().bytes - bytesBefore);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busy_ = false;
+            if (cost_.seconds == 0.0) {
+                cost_ = {seconds, bytes};
+            } else {
+                cost_.seconds += kCostSmoothing * (seconds - cost_.seconds);
+                cost_.bytes += kCostSmoothing * (bytes - cost_.bytes);
+            }
+        }
+        idle_.notify_all();
+    }
+}
+
+void ThreadedBackend::replay(const Frame& frame) {
+    for (const Command& command : frame) {
+        switch (command.kind) {
+        case Command::Kind::Prepare:
+            backend_->prepareFrame(*command.config);
+            break;
+        case Command::Kind::Static:
+            backend_->drawStatic(command.parts, *command.config);
+            break;
+        case Command::Kind::Cells:
+            backend_->drawCells(command.parts, *command.config);
+            break;
+        case Command::Kind::Title:
+            backend_->renderTitle(command.title);
+            break;
+        case Command::Kind::Palette:
+            backend_->setPalette(command.palette);
+            break;
+        }
+    }
+}
+
+void ThreadedBackend::waitIdle() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return !full_ && !busy_; });
+}
+
+void ThreadedBackend::flush() {
+    if (initialized_) {
+        waitIdle();
+    }
+}
+
+FrameCost ThreadedBackend::frameCost() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cost_;
+}
+
+void ThreadedBackend::wait() {
+    flush();
+    backend_->wait();
+}
+
+bool ThreadedBackend::pollInput(InputEvent& event) {
+    return backend_->pollInput(event);
+}
+
+int ThreadedBackend::inputFd() const {
+    return backend_->inputFd();
+}
+
+BackendStats ThreadedBackend::stats() const {
+    // The writer is idle and, with no new frame from this thread, stays so.
+    if (initialized_) {
+        waitIdle();
+    }
+    BackendStats result = backend_->stats();
+    std::lock_guard<std::mutex> lock(mutex_);
+    result.framesMerged = merged_;
+    return result;
+}
+
+} // namespace hbonsai
@@ -1,12 +1,17 @@
 #include "hbonsai/scenemanager.h"
 
 #include <algorithm>
-#include <chrono>
-#include <thread>
 
 #include "hbonsai/renderer.h"
 
 namespace hbonsai {
+namespace {
+
+bool is_quit_key(const InputEvent& event) {
+    return event.code == KeyCode::Escape || (event.code == KeyCode::Character && event.ch == U'q');
+}
+
+} // namespace
 
 void SceneManager::addScene(std::unique_ptr<Scene> scene) {
     if (scene) {
@@ -15,6 +20,11 @@ void SceneManager::addScene(std::unique_ptr<Scene> scene) {
 }
 
 void SceneManager::run(Renderer& renderer, const AppConfig& appConfig) {
+    SteadyClock clock;
+    run(renderer, appConfig, clock);
+}
+
+void SceneManager::run(Renderer& renderer, const AppConfig& appConfig, Clock& clock) {
     if (scenes_.empty()) {
         return;
     }
@@ -22,32 +32,54 @@ void SceneManager::run(Renderer& renderer, const AppConfig& appConfig) {
     auto current = scenes_.front().get();
     current->onEnter(renderer);
 
-    using Clock = std::chrono::steady_clock;
-    auto previous = Clock::now();
+    double previous = clock.now();
 
-    while (!scenes_.empty()) {
+    while (!scenes_.empty() && !stopRequested_) {
         current = scenes_.front().get();
 
-        auto now = Clock::now();
-        double dt = std::chrono::duration<double>(now - previous).count();
+        double now = clock.now();
+        double dt = now - previous;
         previous = now;
 
+        InputEvent event;
+        bool hadInput = false;
+        while (renderer.pollInput(event)) {
+            hadInput = true;
+            // The screensaver ends on any key; otherwise only q and Esc quit.
+            if (appConfig.screensaver || is_quit_key(event)) {
+                quitByUser_ = true;
+                requestStop();
+                break;
+            }
+            current->onInput(event);
+        }
+        if (stopRequested_) {
+            break;
+        }
+
         current->update(dt);
         current->draw(renderer);
         renderer.render();
+        if (frameHook_) {
+            frameHook_(now);
+        }
 
         if (current->isFinished()) {
             scenes_.pop_front();
+            if (scenes_.empty() && hadInput) {
+                quitByUser_ = true;
+            }
             if (!scenes_.empty()) {
                 current = scenes_.front().get();
                 current->onEnter(renderer);
-                previous = Clock::now();
+                previous = clock.now();
             }
             continue;
         }
 
         double delay = appConfig.timeStep > 0.0f ? std::min<double>(appConfig.timeStep, 0.05) : 0.01;
-        std::this_thread::sleep_for(std::chrono::duration<double>(delay));
+        // Sleep until the next frame is due, or until a key arrives.
+        clock.sleepFor(delay, renderer.inputFd());
     }
 }
 
@@ -0,0 +1,406 @@
+#include "hbonsai/survey.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "hbonsai/bonsai.h"
+#include "hbonsai/layout.h"
+#include "hbonsai/thread_pool.h"
+
+namespace hbonsai {
+namespace {
+
+constexpr long long kBlockSeeds = 2048; // seeds per pool task
+constexpr long long kBlocksPerThread = 8; // blocks per thread in one round, for balance
+constexpr int kBuckets = 10;
+constexpr int kBarWidth = 40;
+
+constexpr long long kSearchBlock = 256; // seeds a --find-seed worker claims at a time
+
+enum Metric { kHeight, kWidth, kParts, kLeaves, kBranches, kShoots, kEdge, kMetricCount };
+
+constexpr std::array<const char*, kMetricCount> kMetricNames = {"height", "width",  "parts", "leaves",
+                                                                "branches", "shoots", "edge"};
+
+using Values = std::array<long long, kMetricCount>;
+
+Values metrics_of(const Bonsai::Summary& summary) {
+    bool empty = summary.minX > summary.maxX;
+    return {empty ? 0 : summary.maxY - summary.minY + 1,
+            empty ? 0 : summary.maxX - summary.minX + 1,
+            summary.parts,
+            summary.leaves,
+            summary.counters.branches,
+            summary.counters.shoots,
+            summary.edge};
+}
+
+// Exact distribution of one non-negative metric: a count per value. Trees are
+// at most a few thousand cells, so the table stays small.
+class Histogram {
+public:
+    void add(long long value) {
+        std::size_t at = static_cast<std::size_t>(std::max(0LL, value));
+        if (at >= counts_.size()) {
+            counts_.resize(at + 1);
+        }
+        ++counts_[at];
+        ++total_;
+        sum_ += value;
+    }
+
+    long long total() const { return total_; }
+    double mean() const { return total_ > 0 ? static_cast<double>(sum_) / static_cast<double>(total_) : 0.0; }
+    long long min() const { return quantile(0.0); }
+    long long max() const { return counts_.empty() ? 0 : static_cast<long long>(counts_.size()) - 1; }
+
+    // Smallest value with at least q of the trees at or below it.
+    long long quantile(double q) const {
+        long long need = std::max(1LL, static_cast<long long>(q * static_cast<double>(total_) + 0.999999));
+        long long seen = 0;
+        for (std::size_t value = 0; value < counts_.size(); ++value) {
+            seen += counts_[value];
+            if (seen >= need) {
+                return static_cast<long long>(value);
+            }
+        }
+        return max();
+    }
+
+    long long countBetween(long long low, long long high) const {
+        long long count = 0;
+        for (long long value = std::max(0LL, low); value <= high && value <= max(); ++value) {
+            count += counts_[static_cast<std::size_t>(value)];
+        }
+        return count;
+    }
+
+private:
+    std::vector<long long> counts_;
+    long long total_ = 0;
+    long long sum_ = 0;
+};
+
+void print_histogram(std::ostream& os, const char* name, const Histogram& histogram) {
+    long long low = histogram.min();
+    long long high = histogram.max();
+    os << std::left << std::setw(9) << name << std::right << " min " << low << "  p10 " << histogram.quantile(0.1)
+       << "  p50 " << histogram.quantile(0.5) << "  p90 " << histogram.quantile(0.9) << "  max " << high
+       << "  mean " << std::fixed << std::setprecision(1) << histogram.mean() << std::defaultfloat << "\n";
+
+    long long span = high - low + 1;
+    long long step = (span + kBuckets - 1) / kBuckets;
+    std::vector<std::pair<std::string, long long>> rows;
+    long long peak = 0;
+    for (long long from = low; from <= high; from += step) {
+        long long to = std::min(high, from + step - 1);
+        long long count = histogram.countBetween(from, to);
+        peak = std::max(peak, count);
+        rows.emplace_back(from == to ? std::to_string(from) : std::to_string(from) + "-" + std::to_string(to), count);
+    }
+    for (const auto& [label, count] : rows) {
+        int bar = peak > 0 ? static_cast<int>((count * kBarWidth + peak - 1) / peak) : 0;
+        os << "  " << std::setw(11) << label << " " << std::left << std::setw(kBarWidth) << std::string(bar, '#')
+           << std::right << " " << count << "\n";
+    }
+}
+
+void print_csv_header(std::ostream& os) {
+    os << "seed";
+    for (const char* name : kMetricNames) {
+        os << ',' << name;
+    }
+    os << '\n';
+}
+
+void append_csv(std::string& out, unsigned int seed, const Values& values) {
+    char buffer[24];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), seed);
+    (void)ec;
+    out.append(buffer, end);
+    for (long long value : values) {
+        out.push_back(',');
+        auto [valueEnd, valueEc] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        (void)valueEc;
+        out.append(buffer, valueEnd);
+    }
+    out.push_back('\n');
+}
+
+
+// Inclusive range a --find-seed constraint list allows for each metric.
+struct Bounds {
+    Values low{};
+    Values high;
+
+    Bounds() { high.fill(std::numeric_limits<long long>::max()); }
+
+    bool admits(const Values& values) const {
+        for (std::size_t metric = 0; metric < values.size(); ++metric) {
+            if (values[metric] < low[metric] || values[metric] > high[metric]) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Parses one "name<op>value" constraint, e.g. "shoots>=4" or "width>=80%".
+// Percentages are of the tree area and only apply to height and width.
+bool parse_constraint(const std::string& text, int treeHeight, int treeWidth, Bounds& bounds) {
+    std::size_t opStart = text.find_first_of("<>=");
+    if (opStart == std::string::npos || opStart == 0) {
+        return false;
+    }
+    std::size_t opEnd = text.find_first_not_of("<>=", opStart);
+    if (opEnd == std::string::npos) {
+        return false;
+    }
+    std::string name = text.substr(0, opStart);
+    std::string op = text.substr(opStart, opEnd - opStart);
+    std::string number = text.substr(opEnd);
+
+    auto found = std::find(kMetricNames.begin(), kMetricNames.end(), name);
+    if (found == kMetricNames.end()) {
+        return false;
+    }
+    std::size_t metric = static_cast<std::size_t>(found - kMetricNames.begin());
+
+    bool percent = !number.empty() && number.back() == '%';
+    if (percent) {
+        number.pop_back();
+        if (metric != kHeight && metric != kWidth) {
+            return false;
+        }
+    }
+    long long value = 0;
+    auto [end, ec] = std::from_chars(number.data(), number.data() + number.size(), value);
+    if (ec != std::errc() || end != number.data() + number.size() || value < 0) {
+        return false;
+    }
+
+    bool lower = op == ">=" || op == ">";
+    bool upper = op == "<=" || op == "<";
+    bool equal = op == "==" || op == "=";
+    if (!lower && !upper && !equal) {
+        return false;
+    }
+    if (percent) {
+        // Rounded towards what the bound allows, so 80% of 79 columns asks for 64.
+        long long size = metric == kHeight ? treeHeight : treeWidth;
+        value = lower ? (value * size + 99) / 100 : upper ? value * size / 100 : (value * size + 50) / 100;
+    }
+
+    if (op == ">") {
+        ++value;
+    } else if (op == "<") {
+        --value;
+    }
+    if (lower || equal) {
+        bounds.low[metric] = std::max(bounds.low[metric], value);
+    }
+    if (upper || equal) {
+        bounds.high[metric] = std::min(bounds.high[metric], value);
+    }
+    return true;
+}
+
+int clamp_to_int(long long value) {
+    return static_cast<int>(std::min<long long>(value, std::numeric_limits<int>::max()));
+}
+
+struct Match {
+    long long ordinal = 0;
+    Values values{};
+};
+
+} // namespace
+
+int run_survey(const Config& config) {
+    const AppConfig& app = config.app;
+    int treeHeight = std::max(1, app.surveyRows - base_dimensions(config.bonsai.baseType).first);
+    int treeWidth = app.surveyCols;
+    unsigned int firstSeed = config.bonsai.seed > 0 ? static_cast<unsigned int>(config.bonsai.seed) : 1u;
+
+    // Survey trees are serial trees, so one Bonsai serves every thread.
+    const Bonsai bonsai(config.bonsai);
+    WorkStealingPool pool;
+    long long roundSeeds = kBlockSeeds * kBlocksPerThread * static_cast<long long>(pool.size());
+    std::vector<Bonsai::Summary> summaries;
+    std::array<Histogram, kMetricCount> histograms;
+    std::string csv;
+    long long truncated = 0;
+
+    if (app.surveyCsv) {
+        print_csv_header(std::cout);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (long long done = 0; done < app.survey;) {
+        long long count = std::min(roundSeeds, app.survey - done);
+        summaries.assign(static_cast<std::size_t>(count), Bonsai::Summary{});
+        for (long long block = 0; block < count; block += kBlockSeeds) {
+            pool.submit([&, block, done] {
+                long long end = std::min(count, block + kBlockSeeds);
+                for (long long i = block; i < end; ++i) {
+                    unsigned int seed = firstSeed + static_cast<unsigned int>(done + i);
+                    summaries[static_cast<std::size_t>(i)] = bonsai.survey(seed, treeHeight, treeWidth);
+                }
+            });
+        }
+        pool.wait();
+
+        // Folded in seed order, so the output does not depend on scheduling.
+        csv.clear();
+        for (long long i = 0; i < count; ++i) {
+            const Bonsai::Summary& summary = summaries[static_cast<std::size_t>(i)];
+            truncated += summary.truncation != Truncation::None ? 1 : 0;
+            auto values = metrics_of(summary);
+            if (app.surveyCsv) {
+                append_csv(csv, firstSeed + static_cast<unsigned int>(done + i), values);
+            } else {
+                for (int metric = 0; metric < kMetricCount; ++metric) {
+                    histograms[static_cast<std::size_t>(metric)].add(values[static_cast<std::size_t>(metric)]);
+                }
+            }
+        }
+        std::cout.write(csv.data(), static_cast<std::streamsize>(csv.size()));
+        done += count;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!app.surveyCsv) {
+        std::cout << "survey: " << app.survey << " trees, seeds " << firstSeed << "-"
+                  << firstSeed + static_cast<unsigned int>(app.survey - 1) << ", life " << config.bonsai.lifeStart
+                  << ", multiplier " << config.bonsai.multiplier << ", tree area " << treeHeight << "x" << treeWidth
+                  << "\n";
+        for (int metric = 0; metric < kMetricCount; ++metric) {
+            print_histogram(std::cout, kMetricNames[static_cast<std::size_t>(metric)],
+                            histograms[static_cast<std::size_t>(metric)]);
+        }
+        if (truncated > 0) {
+            std::cout << truncated << " trees were cut short by a generation budget\n";
+        }
+    }
+    std::cout.flush();
+
+    if (app.verbosity > 0) {
+        std::cerr << "survey: " << app.survey << " trees in " << seconds << " s ("
+                  << static_cast<double>(app.survey) / std::max(seconds, 1e-9) << " trees/s on " << pool.size()
+                  << " threads)" << std::endl;
+    }
+    return std::cout ? 0 : 1;
+}
+
+int run_find_seed(const Config& config) {
+    const AppConfig& app = config.app;
+    int treeHeight = std::max(1, app.surveyRows - base_dimensions(config.bonsai.baseType).first);
+    int treeWidth = app.surveyCols;
+    unsigned int firstSeed = config.bonsai.seed > 0 ? static_cast<unsigned int>(config.bonsai.seed) : 1u;
+
+    Bounds bounds;
+    for (const std::string& constraint : app.findSeed) {
+        if (!parse_constraint(constraint, treeHeight, treeWidth, bounds)) {
+            std::cerr << "error: invalid seed constraint: '" << constraint << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    // Every count only grows with the tree, so the upper bounds are what
+    // lets a candidate be dropped before it has finished growing.
+    std::atomic<long long> cutoff{std::numeric_limits<long long>::max()};
+    Bonsai::SurveyLimits limits;
+    limits.height = clamp_to_int(bounds.high[kHeight]);
+    limits.width = clamp_to_int(bounds.high[kWidth]);
+    limits.parts = bounds.high[kParts];
+    limits.leaves = bounds.high[kLeaves];
+    limits.branches = clamp_to_int(bounds.high[kBranches]);
+    limits.shoots = clamp_to_int(bounds.high[kShoots]);
+    limits.edge = bounds.high[kEdge];
+    limits.cutoff = &cutoff;
+
+    const Bonsai bonsai(config.bonsai);
+    WorkStealingPool pool;
+    std::atomic<long long> nextSeed{0};
+    std::atomic<long long> scanned{0};
+    std::atomic<long long> abandoned{0};
+    std::mutex mutex;
+    std::vector<Match> matches; // lowest ordinals first, at most findCount
+
+    // Workers claim seeds in increasing blocks. Once findCount matches are
+    // in, cutoff drops to the highest of them: seeds past it are neither
+    // started nor finished, while every seed below it still is, so the result
+    // is the first findCount matching seeds whatever the thread count.
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned worker = 0; worker < pool.size(); ++worker) {
+        pool.submit([&] {
+            Bonsai::SurveyLimits mine = limits;
+            long long myScanned = 0;
+            long long myAbandoned = 0;
+            while (true) {
+                long long first = nextSeed.fetch_add(kSearchBlock);
+                if (first >= app.findLimit || first > cutoff.load(std::memory_order_relaxed)) {
+                    break;
+                }
+                long long end = std::min(first + kSearchBlock, app.findLimit);
+                for (long long i = first; i < end && i <= cutoff.load(std::memory_order_relaxed); ++i) {
+                    mine.ordinal = i;
+                    Bonsai::Summary summary =
+                        bonsai.survey(firstSeed + static_cast<unsigned int>(i), treeHeight, treeWidth, mine);
+                    ++myScanned;
+                    if (summary.abandoned) {
+                        ++myAbandoned;
+                        continue;
+                    }
+                    Values values = metrics_of(summary);
+                    if (!bounds.admits(values)) {
+                        continue;
+                    }
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    auto before = [](const Match& match, long long ordinal) { return match.ordinal < ordinal; };
+                    auto at = std::lower_bound(matches.begin(), matches.end(), i, before);
+                    matches.insert(at, Match{i, values});
+                    if (matches.size() >= static_cast<std::size_t>(app.findCount)) {
+                        matches.resize(static_cast<std::size_t>(app.findCount));
+                        cutoff.store(matches.back().ordinal, std::memory_order_relaxed);
+                    }
+                }
+            }
+            scanned += myScanned;
+            abandoned += myAbandoned;
+        });
+    }
+    pool.wait();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    print_csv_header(std::cout);
+    std::string csv;
+    for (const Match& match : matches) {
+        append_csv(csv, firstSeed + static_cast<unsigned int>(match.ordinal), match.values);
+    }
+    std::cout << csv << std::flush;
+
+    if (app.verbosity > 0) {
+        std::cerr << "find-seed: " << matches.size() << " matches, " << scanned.load() << " seeds tried ("
+                  << abandoned.load() << " abandoned early) in " << seconds << " s on " << pool.size() << " threads"
+                  << std::endl;
+    }
+    if (matches.size() < static_cast<std::size_t>(app.findCount)) {
+        std::cerr << "error: found " << matches.size() << " of " << app.findCount << " seeds in " << firstSeed << "-"
+                  << firstSeed + static_cast<unsigned int>(app.findLimit - 1) << std::endl;
+        return 1;
+    }
+    return std::cout ? 0 : 1;
+}
+
+} // namespace hbonsai
@@ -0,0 +1,142 @@
+#include "hbonsai/termcaps.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <langinfo.h>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+namespace hbonsai {
+namespace {
+
+// Oldest entries are dropped beyond this many terminals.
+constexpr std::size_t kMaxEntries = 32;
+
+std::string env_or_empty(const char* name) {
+    const char* value = std::getenv(name);
+    std::string result = value ? value : "";
+    // Tabs and newlines are the file's separators.
+    for (char& c : result) {
+        if (c == '\t' || c == '\n') {
+            c = ' ';
+        }
+    }
+    return result;
+}
+
+std::string format_entry(const std::string& identity, const TerminalCaps& caps) {
+    std::ostringstream line;
+    line << identity << '\t' << (caps.utf8 ? 1 : 0) << '\t' << caps.paletteSize << '\t' << (caps.truecolor ? 1 : 0)
+         << '\t' << caps.name;
+    return line.str();
+}
+
+// An entry is the identity's fields followed by four capability fields.
+bool parse_entry(const std::string& line, std::string& identity, TerminalCaps& caps) {
+    std::vector<std::string> fields;
+    std::size_t start = 0;
+    while (true) {
+        std::size_t tab = line.find('\t', start);
+        fields.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+        if (tab == std::string::npos) {
+            break;
+        }
+        start = tab + 1;
+    }
+    if (fields.size() < 5) {
+        return false;
+    }
+
+    std::size_t capsStart = fields.size() - 4;
+    identity.clear();
+    for (std::size_t i = 0; i < capsStart; ++i) {
+        if (i > 0) {
+            identity.push_back('\t');
+        }
+        identity += fields[i];
+    }
+    caps.utf8 = fields[capsStart] == "1";
+    caps.paletteSize = static_cast<unsigned>(std::strtoul(fields[capsStart + 1].c_str(), nullptr, 10));
+    caps.truecolor = fields[capsStart + 2] == "1";
+    caps.name = fields[capsStart + 3];
+    return true;
+}
+
+} // namespace
+
+std::string terminal_identity() {
+    std::string identity = env_or_empty("TERM");
+    for (const char* name : {"COLORTERM", "TERM_PROGRAM", "TERM_PROGRAM_VERSION", "VTE_VERSION"}) {
+        identity.push_back('\t');
+        identity += env_or_empty(name);
+    }
+    identity.push_back('\t');
+    identity += nl_langinfo(CODESET);
+    return identity;
+}
+
+std::string default_termcaps_path() {
+    const char* xdg_cache = std::getenv("XDG_CACHE_HOME");
+    if (xdg_cache && *xdg_cache != '\0') {
+        return std::string(xdg_cache) + "/hbonsai-termcaps";
+    }
+
+    const char* home = std::getenv("HOME");
+    if (home && *home != '\0') {
+        return std::string(home) + "/.cache/hbonsai-termcaps";
+    }
+
+    return "hbonsai-termcaps";
+}
+
+bool load_terminal_caps(const std::string& path, const std::string& identity, TerminalCaps& caps) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    std::string line;
+    std::string entryIdentity;
+    TerminalCaps entry;
+    while (std::getline(in, line)) {
+        if (parse_entry(line, entryIdentity, entry) && entryIdentity == identity) {
+            caps = entry;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool store_terminal_caps(const std::string& path, const std::string& identity, const TerminalCaps& caps) {
+    // Newest first, so lookups for the current terminal stop early.
+    std::vector<std::string> lines{format_entry(identity, caps)};
+    {
+        std::ifstream in(path);
+        std::string line;
+        std::string entryIdentity;
+        TerminalCaps entry;
+        while (std::getline(in, line) && lines.size() < kMaxEntries) {
+            if (parse_entry(line, entryIdentity, entry) && entryIdentity != identity) {
+                lines.push_back(line);
+            }
+        }
+    }
+
+    // Write-then-rename so a concurrent launch never reads a torn file. The
+    // temporary file is removed on failure so they do not pile up.
+    std::string temp = path + ".tmp." + std::to_string(getpid());
+    std::ofstream out(temp, std::ios::trunc);
+    for (const std::string& line : lines) {
+        out << line << '\n';
+    }
+    out.close();
+    if (!out || std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace hbonsai
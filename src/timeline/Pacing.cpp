@@ -0,0 +1,70 @@
+#include "hbonsai/pacing.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hbonsai {
+namespace {
+
+constexpr double kMinInterval = 1.0 / 50.0; // no point outpacing the frame loop
+constexpr double kMaxInterval = 0.5;        // below 2 fps growth stops looking live
+constexpr double kHeadroom = 1.25;          // leave the writer some slack between frames
+
+} // namespace
+
+void GrowthPacer::reset(std::size_t total, double targetSeconds) {
+    total_ = total;
+    target_ = std::max(targetSeconds, 0.0);
+    elapsed_ = 0.0;
+    sinceFrame_ = 0.0;
+    interval_ = kMinInterval;
+    released_ = 0;
+    stats_ = PaceStats{};
+    stats_.targetSeconds = target_;
+}
+
+void GrowthPacer::seek(std::size_t released) {
+    released_ = std::min(released, total_);
+    elapsed_ = total_ > 0 ? target_ * static_cast<double>(released_) / static_cast<double>(total_) : 0.0;
+    sinceFrame_ = 0.0;
+}
+
+std::size_t GrowthPacer::advance(double dt, std::size_t released, const FrameCost& cost) {
+    released_ = released;
+    if (released_ >= total_) {
+        return released_;
+    }
+
+    elapsed_ += dt;
+    sinceFrame_ += dt;
+    stats_.renderMs = cost.seconds * 1000.0;
+    stats_.bytesPerFrame = cost.bytes;
+    interval_ = std::clamp(cost.seconds * kHeadroom, kMinInterval, kMaxInterval);
+
+    bool late = elapsed_ >= target_;
+    if (sinceFrame_ < interval_ && !late) {
+        return released_;
+    }
+    sinceFrame_ = 0.0;
+
+    std::size_t due = total_;
+    if (!late) {
+        double share = elapsed_ / target_;
+        due = std::min(total_, static_cast<std::size_t>(std::ceil(share * static_cast<double>(total_))));
+    }
+    if (due <= released_) {
+        return released_;
+    }
+
+    ++stats_.frames;
+    stats_.partsPerFrame += (static_cast<double>(due - released_) - stats_.partsPerFrame) /
+                            static_cast<double>(stats_.frames);
+    stats_.intervalMs = interval_ * 1000.0;
+    if (due >= total_) {
+        stats_.grownSeconds = elapsed_;
+    }
+    released_ = due;
+    return released_;
+}
+
+} // namespace hbonsai
@@ -0,0 +1,76 @@
+#include "hbonsai/timeline.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace hbonsai {
+namespace {
+
+constexpr std::uint32_t kEmptyCell = std::numeric_limits<std::uint32_t>::max();
+
+std::size_t checkpoint_bytes(const std::vector<std::uint32_t>& checkpoint) {
+    return checkpoint.capacity() * sizeof(std::uint32_t) + sizeof(checkpoint);
+}
+
+} // namespace
+
+GrowthTimeline::GrowthTimeline(std::size_t interval, std::size_t memoryLimit)
+    : interval_(std::max<std::size_t>(1, interval)), memoryLimit_(memoryLimit) {}
+
+void GrowthTimeline::build(const std::vector<TreePart>& parts, int rows, int cols) {
+    checkpoints_.clear();
+    memoryUsage_ = 0;
+    if (rows <= 0 || cols <= 0) {
+        return;
+    }
+
+    // Last part drawn into each cell, plus the list of cells touched so far so
+    // a checkpoint costs O(occupied cells) rather than O(rows * cols).
+    std::vector<std::uint32_t> owner(static_cast<std::size_t>(rows) * static_cast<std::size_t>(cols), kEmptyCell);
+    std::vector<std::uint32_t> occupied;
+
+    for (std::size_t index = 0; index <= parts.size(); ++index) {
+        if (index % interval_ == 0) {
+            std::vector<std::uint32_t> checkpoint;
+            checkpoint.reserve(occupied.size());
+            for (std::uint32_t cell : occupied) {
+                checkpoint.push_back(owner[cell]);
+            }
+            std::sort(checkpoint.begin(), checkpoint.end());
+            memoryUsage_ += checkpoint_bytes(checkpoint);
+            checkpoints_.push_back(std::move(checkpoint));
+
+            while (memoryUsage_ > memoryLimit_ && checkpoints_.size() > 1) {
+                thin();
+            }
+        }
+        if (index == parts.size()) {
+            break;
+        }
+
+        const TreePart& part = parts[index];
+        if (part.y < 0 || part.y >= rows || part.x < 0 || part.x >= cols) {
+            continue;
+        }
+        std::uint32_t cell = static_cast<std::uint32_t>(part.y * cols + part.x);
+        if (owner[cell] == kEmptyCell) {
+            occupied.push_back(cell);
+        }
+        owner[cell] = static_cast<std::uint32_t>(index);
+    }
+}
+
+void GrowthTimeline::thin() {
+    // Keep checkpoints 0, 2, 4, ...; they sit exactly on the doubled interval.
+    std::vector<std::vector<std::uint32_t>> kept;
+    kept.reserve((checkpoints_.size() + 1) / 2);
+    memoryUsage_ = 0;
+    for (std::size_t i = 0; i < checkpoints_.size(); i += 2) {
+        memoryUsage_ += checkpoint_bytes(checkpoints_[i]);
+        kept.push_back(std::move(checkpoints_[i]));
+    }
+    checkpoints_ = std::move(kept);
+    interval_ *= 2;
+}
+
+} // namespace hbonsai
@@ -1,7 +1,8 @@
 #include "hbonsai/title.h"
-#include <algorithm>
 #include <notcurses/notcurses.h>
 
+#include "hbonsai/layout.h"
+
 namespace hbonsai {
 
 Title::Title(const std::string& text) : text_(text) {}
@@ -13,16 +14,7 @@ void Title::render(ncplane* plane) {
         unsigned cols = 0;
         ncplane_dim_yx(plane, &rows, &cols);
 
-        int x_pos = static_cast<int>(cols) - static_cast<int>(text_.length());
-        x_pos = x_pos > 0 ? x_pos / 2 : 0;
-
-        int y_pos = 0;
-        if (rows > 0) {
-            int suggested = static_cast<int>(rows) / 6;
-            suggested = std::max(1, suggested);
-            y_pos = std::min(static_cast<int>(rows) - 1, suggested);
-        }
-
+        auto [y_pos, x_pos] = title_position(text_, static_cast<int>(rows), static_cast<int>(cols));
         ncplane_putstr_yx(plane, y_pos, x_pos, text_.c_str());
     }
 }
@@ -0,0 +1,157 @@
+#include "hbonsai/utf8.h"
+
+#include <cstddef>
+#include <cwchar>
+
+namespace hbonsai {
+namespace {
+
+bool in_range(char32_t cp, char32_t first, char32_t last) {
+    return cp >= first && cp <= last;
+}
+
+constexpr char32_t kZeroWidthJoiner = 0x200D;
+constexpr char32_t kEmojiPresentation = 0xFE0F;
+
+bool is_regional_indicator(char32_t cp) {
+    return in_range(cp, 0x1F1E6, 0x1F1FF);
+}
+
+// Code points that attach to the preceding cluster (Grapheme_Extend, SpacingMark
+// and emoji modifiers, approximated by ranges plus zero-width characters).
+bool is_extend(char32_t cp) {
+    if (in_range(cp, 0x0300, 0x036F) || in_range(cp, 0x1AB0, 0x1AFF) || in_range(cp, 0x1DC0, 0x1DFF) ||
+        in_range(cp, 0x20D0, 0x20FF) || in_range(cp, 0xFE20, 0xFE2F) || in_range(cp, 0xFE00, 0xFE0F) ||
+        in_range(cp, 0xE0100, 0xE01EF) || in_range(cp, 0x1F3FB, 0x1F3FF) || in_range(cp, 0xE0020, 0xE007F) ||
+        cp == kZeroWidthJoiner) {
+        return true;
+    }
+    return cp >= 0x80 && wcwidth(static_cast<wchar_t>(cp)) == 0;
+}
+
+int cluster_width(const std::u32string& cluster) {
+    if (cluster.size() >= 2 && is_regional_indicator(cluster[0])) {
+        return 2; // flag
+    }
+    for (char32_t cp : cluster) {
+        if (cp == kEmojiPresentation) {
+            return 2;
+        }
+    }
+    int width = wcwidth(static_cast<wchar_t>(cluster[0]));
+    return width <= 0 ? 1 : width;
+}
+
+} // namespace
+
+std::wstring utf8_to_wstring(const std::string& input) {
+    std::wstring output;
+    output.reserve(input.size());
+
+    size_t i = 0;
+    while (i < input.size()) {
+        unsigned char byte = static_cast<unsigned char>(input[i]);
+        char32_t codepoint = 0;
+        size_t continuation_count = 0;
+
+        if ((byte & 0x80u) == 0) {
+            codepoint = byte;
+        } else if ((byte & 0xE0u) == 0xC0u) {
+            codepoint = byte & 0x1Fu;
+            continuation_count = 1;
+        } else if ((byte & 0xF0u) == 0xE0u) {
+            codepoint = byte & 0x0Fu;
+            continuation_count = 2;
+        } else if ((byte & 0xF8u) == 0xF0u) {
+            codepoint = byte & 0x07u;
+            continuation_count = 3;
+        } else {
+            ++i;
+            continue;
+        }
+
+        if (i + continuation_count >= input.size()) {
+            break;
+        }
+
+        bool valid = true;
+        for (size_t j = 1; j <= continuation_count; ++j) {
+            unsigned char follow = static_cast<unsigned char>(input[i + j]);
+            if ((follow & 0xC0u) != 0x80u) {
+                valid = false;
+                break;
+            }
+            codepoint = (codepoint << 6) | (follow & 0x3Fu);
+        }
+
+        if (!valid) {
+            ++i;
+            continue;
+        }
+
+        output.push_back(static_cast<wchar_t>(codepoint));
+        i += continuation_count + 1;
+    }
+
+    return output;
+}
+
+void append_utf8(std::string& output, char32_t codepoint) {
+    if (codepoint < 0x80) {
+        output.push_back(static_cast<char>(codepoint));
+    } else if (codepoint < 0x800) {
+        output.push_back(static_cast<char>(0xC0u | (codepoint >> 6)));
+        output.push_back(static_cast<char>(0x80u | (codepoint & 0x3Fu)));
+    } else if (codepoint < 0x10000) {
+        output.push_back(static_cast<char>(0xE0u | (codepoint >> 12)));
+        output.push_back(static_cast<char>(0x80u | ((codepoint >> 6) & 0x3Fu)));
+        output.push_back(static_cast<char>(0x80u | (codepoint & 0x3Fu)));
+    } else {
+        output.push_back(static_cast<char>(0xF0u | (codepoint >> 18)));
+        output.push_back(static_cast<char>(0x80u | ((codepoint >> 12) & 0x3Fu)));
+        output.push_back(static_cast<char>(0x80u | ((codepoint >> 6) & 0x3Fu)));
+        output.push_back(static_cast<char>(0x80u | (codepoint & 0x3Fu)));
+    }
+}
+
+std::vector<Grapheme> split_graphemes(const std::string& input) {
+    std::wstring codepoints = utf8_to_wstring(input);
+    std::vector<Grapheme> clusters;
+
+    std::u32string current;
+    auto flush = [&]() {
+        if (current.empty()) {
+            return;
+        }
+        Grapheme grapheme;
+        for (char32_t cp : current) {
+            append_utf8(grapheme.utf8, cp);
+        }
+        grapheme.first = static_cast<wchar_t>(current[0]);
+        grapheme.width = cluster_width(current);
+        clusters.push_back(std::move(grapheme));
+        current.clear();
+    };
+
+    for (wchar_t wc : codepoints) {
+        char32_t cp = static_cast<char32_t>(wc);
+        bool joins = false;
+        if (!current.empty()) {
+            char32_t previous = current.back();
+            if (is_extend(cp) || previous == kZeroWidthJoiner) {
+                joins = true;
+            } else if (is_regional_indicator(cp) && current.size() == 1 && is_regional_indicator(previous)) {
+                joins = true;
+            }
+        }
+        if (!joins) {
+            flush();
+        }
+        current.push_back(cp);
+    }
+    flush();
+
+    return clusters;
+}
+
+} // namespace hbonsai
@@ -0,0 +1,104 @@
+// Measures how long hbonsaid takes to answer a client, from connect to the
+// last byte of the tree, on its own and while other clients hold connections
+// open without sending their request.
+//
+//   bench_daemon [REQUESTS] [STALLED]
+//
+// The daemon runs in-process on a private socket with the default pool
+// settings. Requests are spaced a few milliseconds apart, like shells
+// starting, so they measure the ready-pool path rather than generation.
+
+#include <algorithm>
+#include <chrono>
+#include <clocale>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "hbonsai/config.h"
+#include "hbonsai/daemon.h"
+
+namespace {
+
+constexpr int kRows = 24;
+constexpr int kCols = 80;
+constexpr auto kSpacing = std::chrono::milliseconds(5);
+
+int connect_silently(const std::string& path) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+void measure(const char* name, const hbonsai::Config& config, int requests) {
+    std::vector<double> latencies;
+    std::string tree;
+    for (int i = 0; i < requests; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        if (!hbonsai::fetch_tree(config.app.socketPath, config.bonsai, kRows, kCols, tree)) {
+            std::fprintf(stderr, "error: no answer from the daemon\n");
+            std::exit(1);
+        }
+        latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        std::this_thread::sleep_for(kSpacing);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto at = [&](double q) { return latencies[static_cast<std::size_t>(q * static_cast<double>(latencies.size() - 1))]; };
+    std::printf("%-24s %10.3f %10.3f %10.3f %10.3f\n", name, at(0.5), at(0.9), at(0.99), latencies.back());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::setlocale(LC_ALL, "");
+    int requests = argc > 1 ? std::max(1, std::atoi(argv[1])) : 500;
+    int stalled = argc > 2 ? std::max(0, std::atoi(argv[2])) : 16;
+
+    hbonsai::Config config;
+    config.app.daemon = true;
+    config.app.socketPath = "/tmp/hbonsai-bench-" + std::to_string(::getpid()) + ".sock";
+
+    std::thread daemon([&] { hbonsai::run_daemon(config); });
+    std::string tree;
+    for (int i = 0; i < 200 && !hbonsai::fetch_tree(config.app.socketPath, config.bonsai, kRows, kCols, tree); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // Let the refill threads fill the pools first.
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    std::printf("%d requests for %dx%d trees, latency in ms\n", requests, kRows, kCols);
+    std::printf("%-24s %10s %10s %10s %10s\n", "", "p50", "p90", "p99", "max");
+    measure("alone", config, requests);
+
+    std::vector<int> idle;
+    for (int i = 0; i < stalled; ++i) {
+        idle.push_back(connect_silently(config.app.socketPath));
+    }
+    std::string label = std::to_string(stalled) + " stalled clients";
+    measure(label.c_str(), config, requests);
+    for (int fd : idle) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    // run_daemon() returns once its SIGTERM handler has set the stop flag.
+    // Sent to the daemon's thread, the handler runs on the thread that polls
+    // the flag.
+    ::pthread_kill(daemon.native_handle(), SIGTERM);
+    daemon.join();
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Measures Bonsai::generate throughput for a few representative configurations.
+//
+//   bench_generate [TREES]
+//
+// Seeds are fixed so runs are comparable across builds.
+
+#include <algorithm>
+#include <chrono>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "hbonsai/bonsai.h"
+
+namespace {
+
+struct Case {
+    const char* name;
+    int lifeStart;
+    int multiplier;
+    int rows;
+    int cols;
+};
+
+constexpr Case kCases[] = {
+    {"default 32/5 50x160", 32, 5, 46, 160},
+    {"bushy 48/8 50x160", 48, 8, 46, 160},
+    {"tall 80/3 100x300", 80, 3, 96, 300},
+};
+
+constexpr int kRounds = 5;
+
+// A deliberately huge tree for the parallel engine's scaling table.
+constexpr Case kHugeCase = {"huge 110/3 200x400", 110, 3, 200, 400};
+
+double time_huge_tree(int threads) {
+    hbonsai::BonsaiConfig config;
+    config.lifeStart = kHugeCase.lifeStart;
+    config.multiplier = kHugeCase.multiplier;
+    config.seed = 7;
+    config.parallel = true;
+    config.threads = threads;
+
+    hbonsai::Bonsai bonsai(config);
+    double best = 0.0;
+    for (int round = 0; round < kRounds; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        bonsai.generate(kHugeCase.rows, kHugeCase.cols);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (round == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::setlocale(LC_ALL, "");
+    int trees = argc > 1 ? std::atoi(argv[1]) : 500;
+    if (trees <= 0) {
+        trees = 500;
+    }
+
+    std::printf("%-22s %10s %12s %10s %10s\n", "case", "trees/s", "parts/tree", "ns/part", "ns/step");
+    for (const Case& c : kCases) {
+        hbonsai::BonsaiConfig config;
+        config.lifeStart = c.lifeStart;
+        config.multiplier = c.multiplier;
+        config.leaves = {"&", "*"};
+
+        // Report the fastest of several rounds to damp scheduler noise.
+        long long parts = 0;
+        long long steps = 0;
+        double seconds = 0.0;
+        for (int round = 0; round < kRounds; ++round) {
+            parts = 0;
+            steps = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < trees; ++i) {
+                config.seed = i + 1;
+                hbonsai::Bonsai bonsai(config);
+                parts += static_cast<long long>(bonsai.generate(c.rows, c.cols).size());
+                steps += bonsai.lastCounters().steps;
+            }
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (round == 0 || elapsed < seconds) {
+                seconds = elapsed;
+            }
+        }
+
+        std::printf("%-22s %10.0f %12.1f %10.1f %10.1f\n", c.name, trees / seconds,
+                    static_cast<double>(parts) / trees, seconds * 1e9 / static_cast<double>(parts),
+                    seconds * 1e9 / static_cast<double>(steps));
+    }
+
+    std::printf("\nparallel engine, %s\n%8s %10s %8s\n", kHugeCase.name, "threads", "ms/tree", "speedup");
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    double single = time_huge_tree(1);
+    for (unsigned threads = 1; threads <= cores; threads *= 2) {
+        double seconds = threads == 1 ? single : time_huge_tree(static_cast<int>(threads));
+        std::printf("%8u %10.2f %8.2f\n", threads, seconds * 1e3, single / seconds);
+    }
+    return 0;
+}
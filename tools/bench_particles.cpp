@@ -0,0 +1,96 @@
+// Measures the falling-leaves particle layer on a large terminal: simulation
+// plus the ANSI diff of the cells it dirties, per frame, at steady state.
+//
+//   bench_particles [FRAMES]
+//
+// A frame at 30 fps has a 33 ms budget; the p99 column should stay far below it.
+
+#include <algorithm>
+#include <chrono>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "hbonsai/ansi.h"
+#include "hbonsai/bonsai.h"
+#include "hbonsai/layout.h"
+#include "hbonsai/particles.h"
+
+namespace {
+
+constexpr int kRows = 200;
+constexpr int kCols = 400;
+constexpr double kFrame = 1.0 / 30.0;
+constexpr double kWarmupSeconds = 60.0;
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::setlocale(LC_ALL, "");
+    int frames = argc > 1 ? std::atoi(argv[1]) : 900;
+    if (frames <= 0) {
+        frames = 900;
+    }
+
+    hbonsai::BonsaiConfig config;
+    config.lifeStart = 110;
+    config.multiplier = 3;
+    config.seed = 7;
+    hbonsai::Bonsai bonsai(config);
+    int treeHeight = kRows - hbonsai::base_dimensions(config.baseType).first;
+    std::vector<hbonsai::TreePart> parts = bonsai.generate(treeHeight, kCols);
+    std::printf("%dx%d terminal, %zu tree parts\n\n", kRows, kCols, parts.size());
+    std::printf("%9s %9s %11s %11s %9s %9s\n", "capacity", "alive", "cells/frame", "bytes/frame", "mean us", "p99 us");
+
+    for (int capacity : {1000, 4000, 16000}) {
+        hbonsai::AnsiCanvas front(kRows, kCols);
+        hbonsai::compose_tree(front, parts, config);
+        hbonsai::AnsiCanvas back = front;
+
+        hbonsai::LeafParticles particles(capacity);
+        particles.build(parts, bonsai.lastIndex(), treeHeight, kCols);
+        std::vector<hbonsai::TreePart> dirty;
+        std::string out;
+
+        auto frame = [&]() {
+            dirty.clear();
+            out.clear();
+            particles.step(kFrame, dirty);
+            for (const hbonsai::TreePart& cell : dirty) {
+                back.put(cell);
+            }
+            back.encodeDiff(front, out);
+            front = back;
+        };
+        for (double t = 0.0; t < kWarmupSeconds; t += kFrame) {
+            frame();
+        }
+
+        std::vector<double> micros;
+        micros.reserve(static_cast<std::size_t>(frames));
+        long long cells = 0;
+        long long bytes = 0;
+        long long alive = 0;
+        for (int i = 0; i < frames; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            frame();
+            micros.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+            cells += static_cast<long long>(dirty.size());
+            bytes += static_cast<long long>(out.size());
+            alive += static_cast<long long>(particles.alive());
+        }
+
+        double mean = 0.0;
+        for (double us : micros) {
+            mean += us;
+        }
+        mean /= static_cast<double>(frames);
+        std::sort(micros.begin(), micros.end());
+        double p99 = micros[static_cast<std::size_t>(frames * 99 / 100)];
+        std::printf("%9d %9lld %11lld %11lld %9.1f %9.1f\n", capacity, alive / frames, cells / frames, bytes / frames,
+                    mean, p99);
+    }
+    return 0;
+}
@@ -0,0 +1,273 @@
+// Measures the terminal backends through a pseudo-terminal, so draw and render
+// costs can be compared without a real terminal in the loop.
+//
+//   bench_render [--backend=ansi|notcurses|broadcast] [--outputs=N] [FRAMES]
+//                [ROWSxCOLS ...]
+//
+// For every size, a pty of that size is opened and the backend is attached
+// to its slave side (N ptys for the broadcast backend, default 8); a reader thread drains the master side and answers the
+// device-attributes query notcurses sends on startup. Three workloads run:
+//
+//   static  a whole new tree per frame (prepareFrame + drawStatic + render)
+//   live    one more part per frame, as live mode grows a tree
+//   title   the finished tree with the title shown and hidden on alternate
+//           frames
+//
+// Reported per frame: mean and p99 time of the draw calls plus render(), and
+// bytes written to the terminal.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "hbonsai/ansi_backend.h"
+#include "hbonsai/bonsai.h"
+#include "hbonsai/broadcast_backend.h"
+#include "hbonsai/notcurses_backend.h"
+#include "hbonsai/renderer.h"
+
+namespace {
+
+struct Size {
+    int rows;
+    int cols;
+};
+
+constexpr Size kDefaultSizes[] = {{24, 80}, {50, 160}, {100, 300}};
+constexpr int kTrees = 8;
+
+// Pty pair with a thread that swallows everything the backend writes.
+class Pty {
+public:
+    explicit Pty(Size size) {
+        master_ = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master_ < 0 || grantpt(master_) != 0 || unlockpt(master_) != 0) {
+            return;
+        }
+        slave_ = open(ptsname(master_), O_RDWR | O_NOCTTY);
+        if (slave_ < 0) {
+            return;
+        }
+        struct winsize ws {};
+        ws.ws_row = static_cast<unsigned short>(size.rows);
+        ws.ws_col = static_cast<unsigned short>(size.cols);
+        ioctl(slave_, TIOCSWINSZ, &ws);
+        reader_ = std::thread([this] { drain(); });
+    }
+
+    ~Pty() {
+        stop_ = true;
+        if (reader_.joinable()) {
+            reader_.join();
+        }
+        if (slave_ >= 0) {
+            close(slave_);
+        }
+        if (master_ >= 0) {
+            close(master_);
+        }
+    }
+
+    bool ok() const { return slave_ >= 0; }
+    int slave() const { return slave_; }
+
+private:
+    void drain() {
+        char buffer[65536];
+        std::string tail;
+        while (!stop_) {
+            struct pollfd pfd {master_, POLLIN, 0};
+            if (poll(&pfd, 1, 20) <= 0) {
+                continue;
+            }
+            ssize_t count = read(master_, buffer, sizeof(buffer));
+            if (count <= 0) {
+                continue;
+            }
+            // Answer primary device attributes like a VT220, which ends
+            // notcurses' startup interrogation.
+            tail.append(buffer, static_cast<std::size_t>(count));
+            if (tail.find("\033[c") != std::string::npos) {
+                static constexpr char kReply[] = "\033[?62;22c";
+                ssize_t ignored = write(master_, kReply, sizeof(kReply) - 1);
+                (void)ignored;
+                tail.clear();
+            }
+            if (tail.size() > 16) {
+                tail.erase(0, tail.size() - 16);
+            }
+        }
+    }
+
+    int master_ = -1;
+    int slave_ = -1;
+    std::atomic<bool> stop_{false};
+    std::thread reader_;
+};
+
+struct Stats {
+    std::vector<double> micros;
+    long long bytes = 0;
+};
+
+void print_row(const std::string& backend, Size size, const char* workload, Stats& stats) {
+    if (stats.micros.empty()) {
+        return;
+    }
+    double mean = 0.0;
+    for (double us : stats.micros) {
+        mean += us;
+    }
+    std::size_t frames = stats.micros.size();
+    mean /= static_cast<double>(frames);
+    std::sort(stats.micros.begin(), stats.micros.end());
+    double p99 = stats.micros[frames * 99 / 100];
+    std::printf("%-12s %4dx%-4d %-7s %7zu %10.1f %10.1f %12lld\n", backend.c_str(), size.rows, size.cols, workload,
+                frames, mean, p99, stats.bytes / static_cast<long long>(frames));
+}
+
+std::unique_ptr<hbonsai::RenderBackend> make_backend(const std::string& name,
+                                                     const std::vector<std::unique_ptr<Pty>>& ptys) {
+    const Pty& pty = *ptys.front();
+    if (name == "ansi") {
+        return std::make_unique<hbonsai::AnsiBackend>(dup(pty.slave()));
+    }
+    if (name == "broadcast") {
+        std::vector<int> fds;
+        for (const auto& output : ptys) {
+            fds.push_back(dup(output->slave()));
+        }
+        return std::make_unique<hbonsai::BroadcastBackend>(fds);
+    }
+    // notcurses writes to the FILE but reads the terminal's replies from
+    // stdin, so both have to be the pty while it runs.
+    dup2(pty.slave(), STDIN_FILENO);
+    std::FILE* out = fdopen(dup(pty.slave()), "w");
+    return std::make_unique<hbonsai::NotcursesBackend>(out);
+}
+
+// Times one frame: the draw calls in `draw`, then render().
+template <class Draw>
+void frame(hbonsai::Renderer& renderer, Stats& stats, Draw&& draw) {
+    long long before = renderer.stats().bytes;
+    auto start = std::chrono::steady_clock::now();
+    draw();
+    renderer.render();
+    stats.micros.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    stats.bytes += renderer.stats().bytes - before;
+}
+
+void bench(const std::string& backend, Size size, int frames, int outputs) {
+    std::vector<std::unique_ptr<Pty>> ptys;
+    for (int i = 0; i < (backend == "broadcast" ? outputs : 1); ++i) {
+        ptys.push_back(std::make_unique<Pty>(size));
+        if (!ptys.back()->ok()) {
+            std::fprintf(stderr, "error: cannot open a pty\n");
+            return;
+        }
+    }
+
+    hbonsai::Renderer renderer(make_backend(backend, ptys));
+    if (!renderer.isInitialized()) {
+        std::fprintf(stderr, "error: %s backend failed to start\n", backend.c_str());
+        return;
+    }
+
+    std::string label = backend == "broadcast" ? "broadcast/" + std::to_string(outputs) : backend;
+    hbonsai::BonsaiConfig config;
+    config.message = "a bonsai";
+    hbonsai::TitleConfig title;
+    auto [rows, cols] = renderer.dimensions();
+    int treeHeight = std::max(1, rows - hbonsai::Renderer::baseHeightForType(config.baseType));
+
+    std::vector<std::vector<hbonsai::TreePart>> trees;
+    for (int seed = 1; seed <= kTrees; ++seed) {
+        config.seed = seed;
+        hbonsai::Bonsai bonsai(config);
+        trees.push_back(bonsai.generate(treeHeight, cols));
+    }
+    const std::vector<hbonsai::TreePart>& grown = trees.front();
+
+    Stats still;
+    for (int i = 0; i < frames; ++i) {
+        const auto& tree = trees[static_cast<std::size_t>(i % kTrees)];
+        frame(renderer, still, [&] {
+            renderer.prepareFrame(config);
+            renderer.drawStatic(tree, config);
+        });
+    }
+    print_row(label, size, "static", still);
+
+    Stats live;
+    renderer.prepareFrame(config);
+    renderer.render();
+    std::vector<std::size_t> next(1);
+    for (std::size_t i = 0; i < grown.size() && static_cast<int>(i) < frames * 10; ++i) {
+        next[0] = i;
+        frame(renderer, live, [&] { renderer.drawLive(grown, next, config); });
+    }
+    print_row(label, size, "live", live);
+
+    Stats titled;
+    for (int i = 0; i < frames; ++i) {
+        frame(renderer, titled, [&] {
+            renderer.drawStatic(grown, config);
+            if (i % 2 == 0) {
+                renderer.renderTitle(title);
+            }
+        });
+    }
+    print_row(label, size, "title", titled);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::setlocale(LC_ALL, "");
+
+    std::vector<std::string> backends = {"ansi", "notcurses"};
+    std::vector<Size> sizes;
+    int frames = 200;
+    int outputs = 8;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        Size size{};
+        if (arg.rfind("--backend=", 0) == 0) {
+            backends = {arg.substr(10)};
+        } else if (arg.rfind("--outputs=", 0) == 0 && std::atoi(arg.c_str() + 10) > 0) {
+            outputs = std::atoi(arg.c_str() + 10);
+        } else if (std::sscanf(arg.c_str(), "%dx%d", &size.rows, &size.cols) == 2 && size.rows > 0 && size.cols > 0) {
+            sizes.push_back(size);
+        } else if (std::atoi(arg.c_str()) > 0) {
+            frames = std::atoi(arg.c_str());
+        } else {
+            std::fprintf(stderr, "usage: bench_render [--backend=ansi|notcurses|broadcast] [--outputs=N] [FRAMES] "
+                                 "[ROWSxCOLS ...]\n");
+            return 2;
+        }
+    }
+    if (sizes.empty()) {
+        sizes.assign(std::begin(kDefaultSizes), std::end(kDefaultSizes));
+    }
+
+    std::printf("%-12s %9s %-7s %7s %10s %10s %12s\n", "backend", "size", "load", "frames", "mean us", "p99 us",
+                "bytes/frame");
+    for (const std::string& backend : backends) {
+        for (Size size : sizes) {
+            bench(backend, size, frames, outputs);
+        }
+    }
+    return 0;
+}
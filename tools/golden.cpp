@@ -0,0 +1,534 @@
+// Golden-corpus check for the tree generators.
+//
+//   golden [--update] [CORPUS]
+//
+// Every line of the corpus names a tree (seed, life, multiplier, size and
+// leaves) and stores FNV-1a hashes of what Bonsai::generate returned for it:
+// the ordered x, y, ch, colorIndex and bold of every part, over two
+// successive trees from one Bonsai as infinite mode draws them. Each case is
+// checked against
+//
+//   - the serial engine, which must match the stored hash exactly;
+//   - a straight port of ref.c's branch(), which must match the serial engine;
+//   - the parallel engine on 1 and 4 threads, which must match its own stored
+//     hash and each other.
+//
+// Cases run on all cores. --update rewrites the corpus from the current
+// engines, but only if the serial engine still agrees with ref.c; do that
+// only for a deliberate change to what a seed draws.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <clocale>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hbonsai/bonsai.h"
+
+#ifndef HBONSAI_GOLDEN_CORPUS
+#define HBONSAI_GOLDEN_CORPUS "golden_corpus.txt"
+#endif
+
+namespace {
+
+constexpr int kTreesPerCase = 2;
+
+struct Case {
+    int seed = 0;
+    int life = 0;
+    int multiplier = 0;
+    int rows = 0;
+    int cols = 0;
+    std::string leaves; // comma-separated, as for --leaf
+    std::uint64_t serial = 0;
+    std::uint64_t parallel = 0;
+};
+
+struct Result {
+    std::uint64_t serial = 0;
+    std::uint64_t reference = 0;
+    std::uint64_t parallel1 = 0;
+    std::uint64_t parallel4 = 0;
+};
+
+class Fnv {
+public:
+    void add(std::uint64_t value) {
+        hash_ ^= value;
+        hash_ *= 1099511628211ULL;
+    }
+
+    void addPart(int x, int y, wchar_t ch, int colorIndex, bool bold) {
+        add(static_cast<std::uint64_t>(x));
+        add(static_cast<std::uint64_t>(y));
+        add(static_cast<std::uint64_t>(ch));
+        add(static_cast<std::uint64_t>(colorIndex));
+        add(static_cast<std::uint64_t>(bold));
+    }
+
+    std::uint64_t value() const { return hash_; }
+
+private:
+    std::uint64_t hash_ = 1469598103934665603ULL;
+};
+
+std::vector<std::string> split_leaves(const std::string& list) {
+    std::vector<std::string> leaves;
+    std::stringstream stream(list);
+    std::string leaf;
+    while (std::getline(stream, leaf, ',')) {
+        leaves.push_back(leaf);
+    }
+    return leaves;
+}
+
+hbonsai::BonsaiConfig config_for(const Case& c) {
+    hbonsai::BonsaiConfig config;
+    config.seed = c.seed;
+    config.lifeStart = c.life;
+    config.multiplier = c.multiplier;
+    config.leaves = split_leaves(c.leaves);
+    return config;
+}
+
+std::uint64_t hash_engine(const Case& c, bool parallel, int threads) {
+    hbonsai::BonsaiConfig config = config_for(c);
+    config.parallel = parallel;
+    config.threads = threads;
+    hbonsai::Bonsai bonsai(config);
+
+    Fnv fnv;
+    for (int tree = 0; tree < kTreesPerCase; ++tree) {
+        for (const auto& part : bonsai.generate(c.rows, c.cols)) {
+            fnv.addPart(part.x, part.y, part.ch, part.colorIndex, part.bold);
+        }
+    }
+    return fnv.value();
+}
+
+// ref.c's tree growth, kept as close to the original text as C++ allows and
+// independent of src/bonsai. The differences are the ones hbonsai has always
+// had, each marked "hbonsai:" below.
+class Reference {
+public:
+    explicit Reference(const Case& c) : case_(c), config_(config_for(c)), rng_(static_cast<unsigned>(c.seed)) {
+        for (const auto& leaf : config_.leaves) {
+            std::wstring wide(leaf.size(), L'\0');
+            std::size_t length = std::mbstowcs(wide.data(), leaf.c_str(), wide.size());
+            if (length != static_cast<std::size_t>(-1) && length > 0) {
+                wide.resize(length);
+                leaves_.push_back(wide);
+            }
+        }
+        if (leaves_.empty()) {
+            leaves_.push_back(L"&");
+        }
+    }
+
+    std::uint64_t run() {
+        for (int tree = 0; tree < kTreesPerCase; ++tree) {
+            growTree();
+        }
+        return fnv_.value();
+    }
+
+private:
+    enum BranchType { trunk, shootLeft, shootRight, dying, dead };
+
+    // hbonsai: rand() % mod is replaced by a uniform draw from mt19937.
+    int rand_mod(int mod) { return std::uniform_int_distribution<int>(0, mod - 1)(rng_); }
+
+    void growTree() {
+        shoots_ = 0;
+        branches_ = 0;
+        shootCounter_ = rand_mod(1000); // hbonsai: rand() % 1000 rather than rand()
+        branch(case_.rows - 1, case_.cols / 2, trunk, config_.lifeStart);
+    }
+
+    void setDeltas(BranchType type, int life, int age, int multiplier, int& returnDx, int& returnDy) {
+        int dx = 0;
+        int dy = 0;
+        int dice;
+        switch (type) {
+        case trunk:
+            if (age <= 2 || life < 4) {
+                dy = 0;
+                dx = rand_mod(3) - 1;
+            } else if (age < (multiplier * 3)) {
+                if (age % static_cast<int>(multiplier * 0.5) == 0) dy = -1;
+                else dy = 0;
+
+                dice = rand_mod(10);
+                if (dice >= 0 && dice <= 0) dx = -2;
+                else if (dice >= 1 && dice <= 3) dx = -1;
+                else if (dice >= 4 && dice <= 5) dx = 0;
+                else if (dice >= 6 && dice <= 8) dx = 1;
+                else if (dice >= 9 && dice <= 9) dx = 2;
+            } else {
+                dice = rand_mod(10);
+                if (dice > 2) dy = -1;
+                else dy = 0;
+                dx = rand_mod(3) - 1;
+            }
+            break;
+
+        case shootLeft:
+            dice = rand_mod(10);
+            if (dice >= 0 && dice <= 1) dy = -1;
+            else if (dice >= 2 && dice <= 7) dy = 0;
+            else if (dice >= 8 && dice <= 9) dy = 1;
+
+            dice = rand_mod(10);
+            if (dice >= 0 && dice <= 1) dx = -2;
+            else if (dice >= 2 && dice <= 5) dx = -1;
+            else if (dice >= 6 && dice <= 8) dx = 0;
+            else if (dice >= 9 && dice <= 9) dx = 1;
+            break;
+
+        case shootRight:
+            dice = rand_mod(10);
+            if (dice >= 0 && dice <= 1) dy = -1;
+            else if (dice >= 2 && dice <= 7) dy = 0;
+            else if (dice >= 8 && dice <= 9) dy = 1;
+
+            dice = rand_mod(10);
+            if (dice >= 0 && dice <= 1) dx = 2;
+            else if (dice >= 2 && dice <= 5) dx = 1;
+            else if (dice >= 6 && dice <= 8) dx = 0;
+            else if (dice >= 9 && dice <= 9) dx = -1;
+            break;
+
+        case dying:
+            dice = rand_mod(10);
+            if (dice >= 0 && dice <= 1) dy = -1;
+            else if (dice >= 2 && dice <= 8) dy = 0;
+            else if (dice >= 9 && dice <= 9) dy = 1;
+
+            dice = rand_mod(15);
+            if (dice >= 0 && dice <= 0) dx = -3;
+            else if (dice >= 1 && dice <= 2) dx = -2;
+            else if (dice >= 3 && dice <= 5) dx = -1;
+            else if (dice >= 6 && dice <= 8) dx = 0;
+            else if (dice >= 9 && dice <= 11) dx = 1;
+            else if (dice >= 12 && dice <= 13) dx = 2;
+            else if (dice >= 14 && dice <= 14) dx = 3;
+            break;
+
+        case dead:
+            dice = rand_mod(10);
+            if (dice >= 0 && dice <= 2) dy = -1;
+            else if (dice >= 3 && dice <= 6) dy = 0;
+            else if (dice >= 7 && dice <= 9) dy = 1;
+            dx = rand_mod(3) - 1;
+            break;
+        }
+
+        returnDx = dx;
+        returnDy = dy;
+    }
+
+    // Returns the colour index and sets bold, like chooseColor's wattron.
+    int chooseColor(BranchType type, bool& bold) {
+        const auto& colors = config_.colors;
+        switch (type) {
+        case trunk:
+        case shootLeft:
+        case shootRight:
+            if (rand_mod(2) == 0) {
+                bold = true;
+                return colors[3];
+            }
+            bold = false;
+            return colors[1];
+        case dying:
+            bold = rand_mod(10) == 0;
+            return colors[2];
+        case dead:
+            bold = rand_mod(3) == 0;
+            return colors[0];
+        }
+        return 0;
+    }
+
+    std::wstring chooseString(BranchType type, int life, int dx, int dy) {
+        std::wstring branchStr = L"?";
+        if (life < 4) type = dying;
+
+        switch (type) {
+        case trunk:
+            if (dy == 0) branchStr = L"/~";
+            else if (dx < 0) branchStr = L"\\|";
+            else if (dx == 0) branchStr = L"/|\\";
+            else if (dx > 0) branchStr = L"|/";
+            break;
+        case shootLeft:
+            if (dy > 0) branchStr = L"\\";
+            else if (dy == 0) branchStr = L"\\_";
+            else if (dx < 0) branchStr = L"\\|";
+            else if (dx == 0) branchStr = L"/|";
+            else if (dx > 0) branchStr = L"/";
+            break;
+        case shootRight:
+            if (dy > 0) branchStr = L"/";
+            else if (dy == 0) branchStr = L"_/";
+            else if (dx < 0) branchStr = L"\\|";
+            else if (dx == 0) branchStr = L"/|";
+            else if (dx > 0) branchStr = L"/";
+            break;
+        case dying:
+        case dead:
+            branchStr = leaves_[static_cast<std::size_t>(rand_mod(static_cast<int>(leaves_.size())))];
+        }
+        return branchStr;
+    }
+
+    // hbonsai: instead of mvwprintw's "x % wcwidth(wc) == 0" check and
+    // ncurses clipping, each code point becomes one cell and cells past the
+    // right edge are dropped.
+    void print(int y, int x, const std::wstring& str, int color, bool bold) {
+        for (wchar_t wc : str) {
+            if (x >= 0 && x < case_.cols) {
+                fnv_.addPart(x, y, wc, color, bold);
+            }
+            x += std::max(1, wcwidth(wc));
+        }
+    }
+
+    void branch(int y, int x, BranchType type, int life) {
+        branches_++;
+        int dx = 0;
+        int dy = 0;
+        int age = 0;
+        int shootCooldown = config_.multiplier;
+
+        while (life > 0) {
+            life--;
+            age = config_.lifeStart - life;
+
+            setDeltas(type, life, age, config_.multiplier, dx, dy);
+
+            int maxY = case_.rows;
+            if (dy > 0 && y > (maxY - 2)) dy--;
+
+            if (life < 3)
+                branch(y, x, dead, life);
+            else if (type == trunk && life < (config_.multiplier + 2))
+                branch(y, x, dying, life);
+            else if ((type == shootLeft || type == shootRight) && life < (config_.multiplier + 2))
+                branch(y, x, dying, life);
+            else if (type == trunk && ((rand_mod(3) == 0) || (life % config_.multiplier == 0))) {
+                if ((rand_mod(8) == 0) && life > 7) {
+                    shootCooldown = config_.multiplier * 2;
+                    branch(y, x, trunk, life + (rand_mod(5) - 2));
+                } else if (shootCooldown <= 0) {
+                    shootCooldown = config_.multiplier * 2;
+                    int shootLife = (life + config_.multiplier);
+                    shoots_++;
+                    shootCounter_++;
+                    // hbonsai: even counts grow right, the reverse of ref.c's
+                    // (shootCounter % 2) + 1.
+                    branch(y, x, shootCounter_ % 2 == 0 ? shootRight : shootLeft, shootLife);
+                }
+            }
+            shootCooldown--;
+
+            x += dx;
+            y += dy;
+
+            // hbonsai: branches stay inside the tree area.
+            x = std::clamp(x, 0, case_.cols - 1);
+            y = std::clamp(y, 0, case_.rows - 1);
+
+            bool bold = false;
+            int color = chooseColor(type, bold);
+            print(y, x, chooseString(type, life, dx, dy), color, bold);
+        }
+    }
+
+    const Case& case_;
+    hbonsai::BonsaiConfig config_;
+    std::mt19937 rng_;
+    std::vector<std::wstring> leaves_;
+    Fnv fnv_;
+    int shoots_ = 0;
+    int branches_ = 0;
+    int shootCounter_ = 0;
+};
+
+Result run_case(const Case& c) {
+    Result result;
+    result.serial = hash_engine(c, false, 0);
+    result.reference = Reference(c).run();
+    result.parallel1 = hash_engine(c, true, 1);
+    result.parallel4 = hash_engine(c, true, 4);
+    return result;
+}
+
+// The cases --update writes: a spread of seeds, lives, densities, sizes and
+// leaf sets. Multiplier 1 is left out because ref.c divides by zero on it.
+std::vector<Case> default_cases() {
+    static const char* const kLeafSets[] = {"&", "&,*,@", "&&,木"};
+    static const int kSizes[][2] = {{12, 40}, {24, 80}, {50, 200}};
+    std::vector<Case> cases;
+    for (int seed = 1; seed <= 12; ++seed) {
+        for (int life : {8, 32, 48, 64}) {
+            for (int multiplier : {2, 5, 9}) {
+                for (const auto& size : kSizes) {
+                    Case c;
+                    c.seed = seed;
+                    c.life = life;
+                    c.multiplier = multiplier;
+                    c.rows = size[0];
+                    c.cols = size[1];
+                    c.leaves = kLeafSets[seed % 3];
+                    cases.push_back(c);
+                }
+            }
+        }
+    }
+    return cases;
+}
+
+bool load_corpus(const std::string& path, std::vector<Case>& cases) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "error: cannot read corpus '" << path << "'" << std::endl;
+        return false;
+    }
+    std::string line;
+    int number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        Case c;
+        std::string serial;
+        std::string parallel;
+        if (!(fields >> c.seed >> c.life >> c.multiplier >> c.rows >> c.cols >> c.leaves >> serial >> parallel)) {
+            std::cerr << "error: " << path << ":" << number << ": malformed line" << std::endl;
+            return false;
+        }
+        c.serial = std::strtoull(serial.c_str(), nullptr, 16);
+        c.parallel = std::strtoull(parallel.c_str(), nullptr, 16);
+        cases.push_back(c);
+    }
+    return true;
+}
+
+bool write_corpus(const std::string& path, const std::vector<Case>& cases) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "error: cannot write corpus '" << path << "'" << std::endl;
+        return false;
+    }
+    out << "# hbonsai golden corpus, written by tools/golden --update.\n"
+        << "# FNV-1a of (x, y, ch, colorIndex, bold) over " << kTreesPerCase
+        << " successive trees per Bonsai.\n"
+        << "# seed life multiplier rows cols leaves serial parallel\n";
+    char hashes[40];
+    for (const Case& c : cases) {
+        std::snprintf(hashes, sizeof(hashes), "%016llx %016llx", static_cast<unsigned long long>(c.serial),
+                      static_cast<unsigned long long>(c.parallel));
+        out << c.seed << ' ' << c.life << ' ' << c.multiplier << ' ' << c.rows << ' ' << c.cols << ' ' << c.leaves
+            << ' ' << hashes << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+void report(const Case& c, const char* what, std::uint64_t expected, std::uint64_t actual) {
+    std::printf("MISMATCH seed %d life %d multiplier %d %dx%d leaves %s: %s %016llx, expected %016llx\n", c.seed,
+                c.life, c.multiplier, c.rows, c.cols, c.leaves.c_str(), what, static_cast<unsigned long long>(actual),
+                static_cast<unsigned long long>(expected));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::setlocale(LC_ALL, "C.UTF-8");
+
+    bool update = false;
+    std::string path = HBONSAI_GOLDEN_CORPUS;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    std::vector<Case> cases;
+    if (update) {
+        cases = default_cases();
+    } else if (!load_corpus(path, cases)) {
+        return 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Result> results(cases.size());
+    std::atomic<std::size_t> next{0};
+    unsigned workers = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    for (unsigned w = 0; w < workers; ++w) {
+        threads.emplace_back([&] {
+            for (std::size_t i = next++; i < cases.size(); i = next++) {
+                results[i] = run_case(cases[i]);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int mismatches = 0;
+    for (std::size_t i = 0; i < cases.size(); ++i) {
+        const Case& c = cases[i];
+        const Result& r = results[i];
+        if (r.reference != r.serial) {
+            report(c, "serial engine vs ref.c", r.reference, r.serial);
+            ++mismatches;
+        }
+        if (r.parallel4 != r.parallel1) {
+            report(c, "parallel engine on 4 threads vs 1", r.parallel1, r.parallel4);
+            ++mismatches;
+        }
+        if (!update && r.serial != c.serial) {
+            report(c, "serial engine", c.serial, r.serial);
+            ++mismatches;
+        }
+        if (!update && r.parallel1 != c.parallel) {
+            report(c, "parallel engine", c.parallel, r.parallel1);
+            ++mismatches;
+        }
+    }
+
+    std::printf("%zu cases, %d mismatches, %.2f s on %u threads\n", cases.size(), mismatches, seconds, workers);
+    if (mismatches > 0) {
+        return 1;
+    }
+
+    if (update) {
+        for (std::size_t i = 0; i < cases.size(); ++i) {
+            cases[i].serial = results[i].serial;
+            cases[i].parallel = results[i].parallel1;
+        }
+        if (!write_corpus(path, cases)) {
+            return 2;
+        }
+        std::printf("wrote %s\n", path.c_str());
+    }
+    return 0;
+}
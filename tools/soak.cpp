@@ -0,0 +1,131 @@
+// Runs the full scene loop -- infinite live mode with the title -- on a
+// virtual clock and a headless backend, and reports resource use per
+// simulated hour. A day of screensaver time takes seconds.
+//
+//   soak [DAYS] [--static]
+//
+// RSS should flatten after the first hour; a steady climb is a leak.
+
+#include <atomic>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <new>
+#include <unistd.h>
+
+#include "hbonsai/bonsai_scene.h"
+#include "hbonsai/clock.h"
+#include "hbonsai/null_backend.h"
+#include "hbonsai/renderer.h"
+#include "hbonsai/scenemanager.h"
+
+namespace {
+
+std::atomic<long long> g_allocations{0};
+
+long resident_kb() {
+    long pages = 0;
+    long resident = 0;
+    std::FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+        resident = 0;
+    }
+    std::fclose(statm);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+double cpu_seconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+int main(int argc, char* argv[]) {
+    std::setlocale(LC_ALL, "");
+    double days = 1.0;
+    bool live = true;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--static") == 0) {
+            live = false;
+        } else if (std::atof(argv[i]) > 0.0) {
+            days = std::atof(argv[i]);
+        }
+    }
+
+    hbonsai::AppConfig app;
+    app.live = live;
+    app.infinite = true;
+    hbonsai::BonsaiConfig bonsai;
+    bonsai.seed = 1;
+    hbonsai::TitleConfig title;
+
+    auto backend = std::make_unique<hbonsai::NullBackend>(50, 160);
+    const hbonsai::NullBackend& calls = *backend;
+    hbonsai::Renderer renderer(std::move(backend));
+    hbonsai::VirtualClock clock;
+    hbonsai::SceneManager manager;
+    manager.addScene(std::make_unique<hbonsai::BonsaiScene>(app, bonsai, title));
+
+    const double end = days * 86400.0;
+    double nextReport = 3600.0;
+    long long lastFrames = 0;
+    long long lastAllocations = g_allocations.load();
+    double lastCpu = cpu_seconds();
+    long firstHourRss = 0;
+
+    std::printf("%8s %8s %10s %10s %12s %12s\n", "hour", "trees", "frames", "rss KB", "allocs/h", "us/frame");
+    manager.setFrameHook([&](double now) {
+        if (now < nextReport) {
+            return;
+        }
+        long long frames = calls.calls().render;
+        long long allocations = g_allocations.load();
+        double cpu = cpu_seconds();
+        long rss = resident_kb();
+        if (firstHourRss == 0) {
+            firstHourRss = rss;
+        }
+        long long trees = live ? calls.calls().prepareFrame : calls.calls().drawStatic;
+        double perFrame = frames > lastFrames ? (cpu - lastCpu) * 1e6 / static_cast<double>(frames - lastFrames) : 0.0;
+        std::printf("%8.0f %8lld %10lld %10ld %12lld %12.2f\n", now / 3600.0, trees, frames, rss,
+                    allocations - lastAllocations, perFrame);
+        std::fflush(stdout);
+
+        lastFrames = frames;
+        lastAllocations = allocations;
+        lastCpu = cpu;
+        nextReport += 3600.0;
+        if (now >= end) {
+            manager.requestStop();
+        }
+    });
+    manager.run(renderer, app, clock);
+
+    long rss = resident_kb();
+    std::printf("\nRSS growth after the first hour: %ld KB\n", rss - firstHourRss);
+    return 0;
+}